@@ -223,7 +223,9 @@ usage() {
 	printf '                 run `gen/strgen.c`. Default is "".\n'
 	printf '    GEN_EMU      Emulator to run string generator code under (leave empty if not\n'
 	printf '                 necessary). This is not necessary when using `gen/strgen.sh`.\n'
-	printf '                 Default is "".\n'
+	printf '                 When cross-compiling, it is also needed to run `gen/libgen.c`,\n'
+	printf '                 which parses the math libraries ahead of time; without it, bc\n'
+	printf '                 parses them at startup. Default is "".\n'
 	printf '\n'
 	printf 'WARNING: even though `configure.sh` supports both option types, short and\n'
 	printf 'long, it does not support handling both at the same time. Use only one type.\n'
@@ -315,6 +317,11 @@ gen_file_list() {
 	_gen_file_list_contents=$(replace "$_gen_file_list_contents" \
 		"$_gen_file_list_needle_obj" "$_gen_file_list_replacement")
 
+	# gen/libgen.c has its own main().
+	_gen_file_list_gen_obj=$(printf '%s\n' "$_gen_file_list_replacement" | sed -e 's| src/main\.o||')
+	_gen_file_list_contents=$(replace "$_gen_file_list_contents" \
+		"GEN_OBJ" "$_gen_file_list_gen_obj")
+
 	_gen_file_list_replacement=$(replace_exts "$_gen_file_list_replacement" "o" "gcda")
 	_gen_file_list_contents=$(replace "$_gen_file_list_contents" \
 		"$_gen_file_list_needle_gcda" "$_gen_file_list_replacement")
@@ -586,6 +593,9 @@ bc_time_test="@tests/all.sh bc $extra_math 1 $generate_tests 1 \$(BC_EXEC)"
 dc_test="@tests/all.sh dc $extra_math 1 $generate_tests 0 \$(DC_EXEC)"
 dc_time_test="@tests/all.sh dc $extra_math 1 $generate_tests 1 \$(DC_EXEC)"
 
+bc_time_startup="@tests/startup.py bc 1000 \$(BC_EXEC)"
+dc_time_startup="@tests/startup.py dc 1000 \$(DC_EXEC)"
+
 timeconst="@tests/bc/timeconst.sh tests/bc/scripts/timeconst.bc \$(BC_EXEC)"
 
 # In order to have cleanup at exit, we need to be in
@@ -616,6 +626,7 @@ if [ "$bc_only" -eq 1 ]; then
 
 	dc_test="@printf 'No dc tests to run\\\\n'"
 	dc_time_test="@printf 'No dc tests to run\\\\n'"
+	dc_time_startup="@printf 'No dc startup to time\\\\n'"
 	vg_dc_test="@printf 'No dc tests to run\\\\n'"
 
 	install_prereqs=" install_execs"
@@ -638,6 +649,7 @@ elif [ "$dc_only" -eq 1 ]; then
 
 	bc_test="@printf 'No bc tests to run\\\\n'"
 	bc_time_test="@printf 'No bc tests to run\\\\n'"
+	bc_time_startup="@printf 'No bc startup to time\\\\n'"
 	vg_bc_test="@printf 'No bc tests to run\\\\n'"
 
 	timeconst="@printf 'timeconst cannot be run because bc is not built\\\\n'"
@@ -898,6 +910,26 @@ else
 	BC_LIB2_O=""
 fi
 
+if [ -n "$bc_lib" ]; then
+
+	BC_LIB_CODE_O="\$(GEN_DIR)/lib_code.o"
+
+	# gen/libgen.c is built with the rest of bc, so it can only run where bc
+	# can. Otherwise, the math libraries are parsed at startup.
+	if [ "$HOSTCC" = "$CC" ] || [ -n "$GEN_EMU" ]; then
+		BC_LIB_CODE_PREREQS=" \$(BC_LIB_GEN)"
+		BC_LIB_CODE_EXEC="\$(GEN_EMU) \$(BC_LIB_GEN)"
+	else
+		BC_LIB_CODE_PREREQS=" \$(BC_LIB_GEN_SH)"
+		BC_LIB_CODE_EXEC="\$(BC_LIB_GEN_SH)"
+	fi
+
+else
+	BC_LIB_CODE_O=""
+	BC_LIB_CODE_PREREQS=""
+	BC_LIB_CODE_EXEC="\$(BC_LIB_GEN_SH)"
+fi
+
 GEN="strgen"
 GEN_EXEC_TARGET="\$(HOSTCC) \$(HOSTCFLAGS) -o \$(GEN_EXEC) \$(GEN_C)"
 CLEAN_PREREQS=" clean_gen"
@@ -941,7 +973,7 @@ if [ "$hist" -eq 0 ]; then
 fi
 
 if [ "$bc" -eq 0 ]; then
-	unneeded="$unneeded bc.c bc_lex.c bc_parse.c"
+	unneeded="$unneeded bc.c bc_lex.c bc_parse.c bytecode.c"
 fi
 
 if [ "$dc" -eq 0 ]; then
@@ -955,7 +987,7 @@ fi
 if [ "$library" -ne 0 ]; then
 	unneeded="$unneeded args.c opt.c read.c file.c main.c"
 	unneeded="$unneeded lang.c lex.c parse.c program.c"
-	unneeded="$unneeded bc.c bc_lex.c bc_parse.c"
+	unneeded="$unneeded bc.c bc_lex.c bc_parse.c bytecode.c"
 	unneeded="$unneeded dc.c dc_lex.c dc_parse.c"
 else
 	unneeded="$unneeded library.c"
@@ -1030,6 +1062,9 @@ contents=$(replace "$contents" "BC_LIB_O" "$bc_lib")
 contents=$(replace "$contents" "BC_HELP_O" "$bc_help")
 contents=$(replace "$contents" "DC_HELP_O" "$dc_help")
 contents=$(replace "$contents" "BC_LIB2_O" "$BC_LIB2_O")
+contents=$(replace "$contents" "BC_LIB_CODE_O" "$BC_LIB_CODE_O")
+contents=$(replace "$contents" "BC_LIB_CODE_PREREQS" "$BC_LIB_CODE_PREREQS")
+contents=$(replace "$contents" "BC_LIB_CODE_EXEC" "$BC_LIB_CODE_EXEC")
 contents=$(replace "$contents" "KARATSUBA_LEN" "$karatsuba_len")
 
 contents=$(replace "$contents" "NLSPATH" "$NLSPATH")
@@ -1070,6 +1105,9 @@ contents=$(replace "$contents" "BC_TIME_TEST" "$bc_time_test")
 contents=$(replace "$contents" "DC_TEST" "$dc_test")
 contents=$(replace "$contents" "DC_TIME_TEST" "$dc_time_test")
 
+contents=$(replace "$contents" "BC_TIME_STARTUP" "$bc_time_startup")
+contents=$(replace "$contents" "DC_TIME_STARTUP" "$dc_time_startup")
+
 contents=$(replace "$contents" "VG_BC_TEST" "$vg_bc_test")
 contents=$(replace "$contents" "VG_DC_TEST" "$vg_dc_test")
 
@@ -0,0 +1,177 @@
+/*
+ * *****************************************************************************
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2018-2020 Gavin D. Howard and contributors.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * *****************************************************************************
+ *
+ * Generates the saved code for the bc math libraries. This is linked with the
+ * rest of bc so that it parses the libraries exactly as bc would.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <setjmp.h>
+
+#include <status.h>
+#include <vector.h>
+#include <lang.h>
+#include <vm.h>
+#include <bc.h>
+
+// This is what makes the saved code, so it has none.
+const uchar bc_lib_code[] = { 0 };
+const size_t bc_lib_code_len = 0;
+
+#if BC_ENABLE_EXTRA_MATH
+const uchar bc_lib2_code[] = { 0 };
+const size_t bc_lib2_code_len = 0;
+#endif // BC_ENABLE_EXTRA_MATH
+
+static const char* const bc_gen_header =
+	"// Copyright (c) 2018-2020 Gavin D. Howard and contributors.\n"
+	"// Licensed under the 2-clause BSD license.\n"
+	"// *** AUTOMATICALLY GENERATED BY gen/libgen.c. DO NOT MODIFY. ***\n\n"
+	"#include <stddef.h>\n\n";
+
+#define IO_ERR (1)
+#define INVALID_PARAMS (3)
+#define PARSE_ERR (4)
+
+#define MAX_WIDTH (74)
+
+static int bc_gen_write(FILE *out, const char *name, const char *define,
+                        const BcVec *code)
+{
+	size_t i;
+	int count = 0;
+
+	if (fprintf(out, "extern const unsigned char %s[];\n", name) < 0 ||
+	    fprintf(out, "extern const size_t %s_len;\n\n", name) < 0 ||
+	    fprintf(out, "#if %s\n", define) < 0 ||
+	    fprintf(out, "const unsigned char %s[] = {\n", name) < 0)
+	{
+		return IO_ERR;
+	}
+
+	for (i = 0; i < code->len; ++i) {
+
+		int val;
+
+		if (!count && fputc('\t', out) == EOF) return IO_ERR;
+
+		val = fprintf(out, "%d,", (uchar) code->v[i]);
+		if (val < 0) return IO_ERR;
+
+		count += val;
+
+		if (count > MAX_WIDTH) {
+			count = 0;
+			if (fputc('\n', out) == EOF) return IO_ERR;
+		}
+	}
+
+	if (!count && fputc('\t', out) == EOF) return IO_ERR;
+
+	if (fprintf(out, "0\n};\n") < 0 ||
+	    fprintf(out, "const size_t %s_len = %lu;\n", name,
+	            (unsigned long) code->len) < 0 ||
+	    fprintf(out, "#endif // %s\n\n", define) < 0)
+	{
+		return IO_ERR;
+	}
+
+	return 0;
+}
+
+static int bc_gen_compile(BcVec *lib, BcVec *lib2) {
+
+	BC_SETJMP_LOCKED(err);
+
+	bc_vm_compile(lib, lib2);
+
+	BC_UNSETJMP;
+
+	return 0;
+
+err:
+	BC_SIG_MAYLOCK;
+	return PARSE_ERR;
+}
+
+int main(int argc, char *argv[]) {
+
+	FILE *out;
+	BcVec lib, lib2;
+	int err;
+
+	if (argc < 2) {
+		printf("usage: %s output\n", argv[0]);
+		return INVALID_PARAMS;
+	}
+
+	vm.name = "bc";
+	vm.read_ret = BC_INST_RET;
+	vm.next = bc_lex_token;
+	vm.parse = bc_parse_parse;
+	vm.expr = bc_parse_expr;
+
+	BC_SIG_LOCK;
+
+	bc_vec_init(&vm.jmp_bufs, sizeof(sigjmp_buf), NULL);
+	bc_vec_init(&lib, sizeof(uchar), NULL);
+	bc_vec_init(&lib2, sizeof(uchar), NULL);
+
+	err = bc_gen_compile(&lib, &lib2);
+	if (err) goto exit;
+
+	err = IO_ERR;
+
+	out = fopen(argv[1], "w");
+	if (out == NULL) goto exit;
+
+	err = fprintf(out, "%s", bc_gen_header) < 0 ? IO_ERR : 0;
+
+	if (!err) err = bc_gen_write(out, "bc_lib_code", "BC_ENABLED", &lib);
+
+#if BC_ENABLE_EXTRA_MATH
+	if (!err) {
+		err = bc_gen_write(out, "bc_lib2_code",
+		                   "BC_ENABLED && BC_ENABLE_EXTRA_MATH", &lib2);
+	}
+#endif // BC_ENABLE_EXTRA_MATH
+
+	if (fclose(out) == EOF) err = IO_ERR;
+
+exit:
+	bc_vec_free(&lib);
+	bc_vec_free(&lib2);
+	return err;
+}
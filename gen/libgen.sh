@@ -0,0 +1,64 @@
+#! /bin/sh
+#
+# SPDX-License-Identifier: BSD-2-Clause
+#
+# Copyright (c) 2018-2020 Gavin D. Howard and contributors.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+#
+
+# This is used instead of gen/libgen.c when that cannot be run, as when cross
+# compiling without an emulator. bc then parses the math libraries at startup.
+
+progname=${0##*/}
+
+if [ $# -lt 1 ]; then
+	echo "usage: $progname output"
+	exit 1
+fi
+
+exec > "$1"
+
+cat<<EOF2
+// Copyright (c) 2018-2020 Gavin D. Howard and contributors.
+// Licensed under the 2-clause BSD license.
+// *** AUTOMATICALLY GENERATED BY gen/libgen.sh. DO NOT MODIFY. ***
+
+#include <stddef.h>
+
+extern const unsigned char bc_lib_code[];
+extern const size_t bc_lib_code_len;
+
+#if BC_ENABLED
+const unsigned char bc_lib_code[] = { 0 };
+const size_t bc_lib_code_len = 0;
+#endif // BC_ENABLED
+
+extern const unsigned char bc_lib2_code[];
+extern const size_t bc_lib2_code_len;
+
+#if BC_ENABLED && BC_ENABLE_EXTRA_MATH
+const unsigned char bc_lib2_code[] = { 0 };
+const size_t bc_lib2_code_len = 0;
+#endif // BC_ENABLED && BC_ENABLE_EXTRA_MATH
+EOF2
@@ -56,6 +56,16 @@ extern const char bc_lib2[];
 extern const char* bc_lib2_name;
 #endif // BC_ENABLE_EXTRA_MATH
 
+// The libraries as parsed by gen/libgen.c when bc was built. They are empty
+// if the build could not run it.
+extern const uchar bc_lib_code[];
+extern const size_t bc_lib_code_len;
+
+#if BC_ENABLE_EXTRA_MATH
+extern const uchar bc_lib2_code[];
+extern const size_t bc_lib2_code_len;
+#endif // BC_ENABLE_EXTRA_MATH
+
 typedef struct BcLexKeyword {
 	uchar data;
 	const char name[9];
@@ -147,6 +157,25 @@ void bc_lex_token(BcLex *l);
 // the first in the expr enum. Note: This only works for binary operators.
 #define BC_PARSE_TOKEN_INST(t) ((uchar) ((t) - BC_LEX_NEG + BC_INST_NEG))
 
+// Marks that bc_parse_optimize() puts on the code it is working on.
+#define BC_PARSE_OPT_TARGET ((uchar) (1<<0))
+#define BC_PARSE_OPT_FOLD ((uchar) (1<<1))
+#define BC_PARSE_OPT_FOLD_END ((uchar) (1<<2))
+
+// What is known about a constant expression while folding.
+#define BC_PARSE_FOLD_INT ((uchar) (1<<0))
+#define BC_PARSE_FOLD_LIT ((uchar) (1<<1))
+#define BC_PARSE_FOLD_NONZERO ((uchar) (1<<2))
+#define BC_PARSE_FOLD_OPS ((uchar) (1<<3))
+
+#define BC_PARSE_FOLD_MAX (16)
+
+typedef struct BcParseFold {
+	size_t start;
+	size_t last;
+	uchar kind;
+} BcParseFold;
+
 typedef enum BcParseStatus {
 
 	BC_PARSE_STATUS_SUCCESS,
@@ -158,6 +187,7 @@ void bc_parse_expr(BcParse *p, uint8_t flags);
 
 void bc_parse_parse(BcParse *p);
 void bc_parse_expr_status(BcParse *p, uint8_t flags, BcParseNext next);
+void bc_parse_optimize(BcParse *p);
 
 extern const char bc_sig_msg[];
 extern const uchar bc_sig_msg_len;
@@ -0,0 +1,127 @@
+/*
+ * *****************************************************************************
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2018-2020 Gavin D. Howard and contributors.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * *****************************************************************************
+ *
+ * Definitions for saving and loading parsed bc code.
+ *
+ */
+
+#ifndef BC_BYTECODE_H
+#define BC_BYTECODE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <status.h>
+#include <vector.h>
+#include <program.h>
+
+#if BC_ENABLED
+
+#define BC_BYTECODE_MAGIC ("bc\x7f" "B")
+#define BC_BYTECODE_MAGIC_LEN (4)
+
+#define BC_BYTECODE_FILE_MAGIC ("bc\x7f" "F")
+#define BC_BYTECODE_FILE_MAGIC_LEN (4)
+
+// This must change whenever the format or the meaning of any instruction does.
+#define BC_BYTECODE_VERSION (3)
+
+// The length of what saved code records about the build that made it.
+#define BC_BYTECODE_BUILD_LEN (5)
+
+// What a file is cached under: the length of its text, and a 128-bit FNV-1a
+// digest of the text, the build, and the names the program had.
+typedef struct BcBytecodeKey {
+	size_t len;
+	uint64_t digest[2];
+} BcBytecodeKey;
+
+// How much of a program existed before some code was parsed. Saved code is
+// only what was added after the mark, and it can only be loaded into a program
+// that is at the same mark.
+typedef struct BcBytecodeMark {
+	size_t fns;
+	size_t vars;
+	size_t arrs;
+	size_t code;
+	size_t labels;
+	size_t consts;
+	size_t strs;
+} BcBytecodeMark;
+
+// Saved code for a whole file. bc parses and runs a file one part at a time,
+// so each part is saved just before it runs, and they are loaded and run the
+// same way.
+typedef struct BcBytecodeFile {
+
+	BcVec buf;
+
+	// The functions that existed before the current part and that it defined
+	// again.
+	BcVec redefs;
+
+	BcBytecodeMark mark;
+
+	// Whether parsing ended at quit.
+	bool quit;
+
+} BcBytecodeFile;
+
+typedef struct BcBytecodeReader {
+	const char *buf;
+	size_t len;
+	size_t i;
+} BcBytecodeReader;
+
+void bc_bytecode_mark(const BcProgram *p, BcBytecodeMark *m);
+void bc_bytecode_save(const BcProgram *p, const BcBytecodeMark *m,
+                      const BcVec *redefs, BcVec *out);
+// If lazy is true, functions are only added by name, and their bodies are
+// left where they are until bc_bytecode_loadSaved() loads them, so buf has to
+// stay valid for as long as the program does.
+bool bc_bytecode_load(BcProgram *p, const char *buf, size_t len, bool lazy);
+void bc_bytecode_loadSaved(BcFunc *f);
+
+void bc_bytecode_key(const BcProgram *p, const char *text, size_t len,
+                     BcBytecodeKey *key);
+void bc_bytecode_fileInit(BcBytecodeFile *f, const BcProgram *p);
+void bc_bytecode_fileFree(BcBytecodeFile *f);
+void bc_bytecode_fileRedef(BcBytecodeFile *f, size_t idx);
+void bc_bytecode_filePart(BcBytecodeFile *f, const BcProgram *p);
+void bc_bytecode_fileEnd(BcBytecodeFile *f, const BcBytecodeKey *key);
+bool bc_bytecode_fileOpen(BcBytecodeReader *r, const BcBytecodeKey *key,
+                          bool *quit);
+bool bc_bytecode_fileNext(BcBytecodeReader *r, BcProgram *p);
+
+#endif // BC_ENABLED
+
+#endif // BC_BYTECODE_H
@@ -37,6 +37,7 @@
 #define BC_LANG_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include <status.h>
 #include <vector.h>
@@ -169,12 +170,20 @@ typedef enum BcInst {
 	BC_INST_JUMP_ZERO,
 
 	BC_INST_CALL,
+	BC_INST_CALL_CONST,
+	BC_INST_CALL_TAIL,
 
 	BC_INST_RET,
 	BC_INST_RET0,
 	BC_INST_RET_VOID,
 
 	BC_INST_HALT,
+
+	// These are only made by bc_parse_optimize(), from common sequences.
+	BC_INST_INC_VAR,
+	BC_INST_DEC_VAR,
+	BC_INST_ASSIGN_VAR,
+	BC_INST_JUMP_VAR_NUM,
 #endif // BC_ENABLED
 
 	BC_INST_POP,
@@ -208,6 +217,13 @@ typedef enum BcInst {
 
 } BcInst;
 
+// How many instructions there are. This has to follow the last one.
+#if DC_ENABLED
+#define BC_INST_COUNT (BC_INST_NQUIT + 1)
+#else // DC_ENABLED
+#define BC_INST_COUNT (BC_INST_POP + 1)
+#endif // DC_ENABLED
+
 typedef struct BcId {
 	char *name;
 	size_t idx;
@@ -218,10 +234,56 @@ typedef struct BcLoc {
 	size_t idx;
 } BcLoc;
 
+// Arrays shorter than this are always dense. Past it, an array switches to a
+// hash table of the elements that were used when an index jumps this far past
+// its end and past twice its length, or when an index that skips at least
+// BC_ARRAY_SPARSE_DENSITY elements takes it past a power of two with fewer
+// than one in BC_ARRAY_SPARSE_DENSITY elements nonzero.
+#define BC_ARRAY_SPARSE_GAP ((size_t) 1 << 12)
+#define BC_ARRAY_SPARSE_DENSITY (8)
+
+// Marks an empty slot in the table; BC_MAX_DIM is below it.
+#define BC_ARRAY_SPARSE_NONE (SIZE_MAX)
+
+typedef struct BcArrElem {
+	size_t idx;
+	BcNum n;
+} BcArrElem;
+
+// A sparse array is a vector holding only this. Its length is the same as if
+// it were dense, but elements that were never used take no space.
+typedef struct BcSparse {
+	size_t len;
+	size_t used;
+	size_t cap;
+	BcArrElem *elems;
+} BcSparse;
+
+// An array can be told apart by the size of its elements: BcNum for a dense
+// array, BcSparse for a sparse one, BcLoc for one that shares the contents of
+// another, and uchar for a reference. This fails to compile if two of those
+// sizes were ever the same.
+#define BC_ARRAY_SPARSE(a) ((a)->size == sizeof(BcSparse))
+
+typedef char BcArrayKinds[(sizeof(BcNum) != sizeof(BcSparse) &&
+                           sizeof(BcNum) != sizeof(BcLoc) &&
+                           sizeof(BcNum) != sizeof(uchar) &&
+                           sizeof(BcSparse) != sizeof(BcLoc) &&
+                           sizeof(BcSparse) != sizeof(uchar) &&
+                           sizeof(BcLoc) != sizeof(uchar)) ? 1 : -1];
+
+#define BC_CONST_BASES (4)
+
 typedef struct BcConst {
 	char *val;
-	BcBigDig base;
-	BcNum num;
+#if BC_ENABLED
+	// If this is not zero, the constant was folded by bc_parse_optimize(), and
+	// val holds this many bytes of the code that computes it.
+	size_t fold;
+#endif // BC_ENABLED
+	size_t nbases;
+	BcBigDig bases[BC_CONST_BASES];
+	BcNum nums[BC_CONST_BASES];
 } BcConst;
 
 typedef struct BcFunc {
@@ -238,7 +300,14 @@ typedef struct BcFunc {
 
 	const char *name;
 #if BC_ENABLED
+	// The saved code of a library function that has not been called yet, or
+	// NULL. Library functions are only loaded when they are first called.
+	const char *saved;
+	size_t saved_len;
+
 	bool voidfn;
+	bool pure;
+	bool lib;
 #endif // BC_ENABLED
 
 } BcFunc;
@@ -254,6 +323,7 @@ typedef enum BcResultType {
 	BC_RESULT_STR,
 
 	BC_RESULT_TEMP,
+	BC_RESULT_CONST,
 
 	BC_RESULT_ZERO,
 	BC_RESULT_ONE,
@@ -306,6 +376,9 @@ void bc_func_free(void *func);
 
 void bc_array_init(BcVec *a, bool nums);
 void bc_array_copy(BcVec *d, const BcVec *s);
+BcNum* bc_array_find(const BcVec *a, size_t idx);
+BcNum* bc_array_item(BcVec *a, size_t idx);
+size_t bc_array_len(const BcVec *a);
 
 void bc_string_free(void *string);
 void bc_const_free(void *constant);
@@ -317,9 +390,9 @@ void bc_result_free(void *result);
 void bc_array_expand(BcVec *a, size_t len);
 int bc_id_cmp(const BcId *e1, const BcId *e2);
 
-#if BC_DEBUG_CODE
+#if BC_DEBUG_CODE || !BC_ENABLE_LIBRARY
 extern const char* bc_inst_names[];
-#endif // BC_DEBUG_CODE
+#endif // BC_DEBUG_CODE || !BC_ENABLE_LIBRARY
 
 extern const char bc_func_main[];
 extern const char bc_func_read[];
@@ -42,6 +42,7 @@
 #include <status.h>
 #include <vector.h>
 #include <lang.h>
+#include <read.h>
 
 #define bc_lex_err(l, e) (bc_vm_handleError((e), (l)->line))
 #define bc_lex_verr(l, e, ...) (bc_vm_handleError((e), (l)->line, __VA_ARGS__))
@@ -63,6 +64,8 @@
 
 #endif // BC_ENABLED
 
+#define BC_LEX_BIN(l, c) ((l)->bin && BC_READ_BIN_CHAR(c))
+
 #define BC_LEX_NUM_CHAR(c, pt, int_only)                          \
 	(isdigit(c) || ((c) >= 'A' && (c) <= BC_LEX_LAST_NUM_CHAR) || \
 	 ((c) == '.' && !(pt) && !(int_only)))
@@ -227,6 +230,10 @@ typedef struct BcLex {
 	BcLexType last;
 	BcVec str;
 
+	// Set when the text has not been checked for binary bytes yet, so the
+	// lexer has to check them as it reaches them.
+	bool bin;
+
 } BcLex;
 
 void bc_lex_init(BcLex *l);
@@ -243,5 +250,6 @@ void bc_lex_name(BcLex *l);
 void bc_lex_commonTokens(BcLex *l, char c);
 
 void bc_lex_invalidChar(BcLex *l, char c);
+void bc_lex_binary(BcLex *l);
 
 #endif // BC_LEX_H
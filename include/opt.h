@@ -55,6 +55,7 @@ typedef enum BcOptType {
 	BC_OPT_REQUIRED,
 	BC_OPT_BC_ONLY,
 	BC_OPT_DC_ONLY,
+	BC_OPT_REQUIRED_BC_ONLY,
 } BcOptType;
 
 typedef struct BcOptLong {
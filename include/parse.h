@@ -91,6 +91,8 @@ typedef struct BcParse {
 	BcVec conds;
 	BcVec ops;
 	BcVec buf;
+	BcVec opt;
+	BcVec offs;
 #endif // BC_ENABLED
 
 	struct BcProgram *prog;
@@ -99,6 +101,10 @@ typedef struct BcParse {
 
 	bool auto_part;
 
+#if BC_ENABLED
+	bool lib;
+#endif // BC_ENABLED
+
 } BcParse;
 
 void bc_parse_init(BcParse *p, struct BcProgram *prog, size_t func);
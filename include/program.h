@@ -56,6 +56,99 @@
 
 #define BC_PROG_ONE_CAP (1)
 
+#if BC_ENABLED
+#define BC_PROG_LIB_CACHE_MAX (32)
+
+typedef struct BcLibCache {
+	size_t fidx;
+	size_t depth;
+	BcBigDig scale;
+	BcNum arg;
+	BcNum res;
+} BcLibCache;
+
+#define BC_PROG_PURE_MAX ((size_t) 1 << 16)
+
+// A result of a pure function. The key holds everything that the result may
+// depend on: the function, scale, ibase, and the values of the arguments.
+typedef struct BcPureEntry {
+	size_t hash;
+	size_t depth;
+	size_t len;
+	char *key;
+	BcNum res;
+} BcPureEntry;
+
+typedef struct BcPure {
+
+	// An open-addressed table, where slots without a key are empty.
+	size_t cap;
+	size_t used;
+	BcPureEntry *table;
+
+	// Calls that missed and are still running, and a buffer to build keys.
+	BcVec pend;
+	BcVec key;
+
+	size_t hits;
+	size_t misses;
+	size_t flushes;
+
+} BcPure;
+#endif // BC_ENABLED
+
+// Only the executables can profile, since the library has no exit to report
+// at.
+#define BC_PROG_PROFILE (!BC_ENABLE_LIBRARY)
+
+#if BC_PROG_PROFILE
+typedef enum BcProfFmt {
+
+	BC_PROF_TEXT,
+	BC_PROF_JSON,
+	BC_PROF_CSV,
+
+} BcProfFmt;
+
+typedef struct BcProfInst {
+
+	uint64_t count;
+	uint64_t ticks;
+
+	// The operands of arithmetic, measured in limbs.
+	uint64_t nums;
+	uint64_t limbs;
+	size_t max;
+
+} BcProfInst;
+
+typedef struct BcProfFunc {
+
+	uint64_t calls;
+	uint64_t insts;
+	uint64_t ticks;
+
+} BcProfFunc;
+
+typedef struct BcProf {
+
+	BcProfInst insts[UCHAR_MAX + 1];
+
+	// One BcProfFunc for each function that has run, by index.
+	BcVec fns;
+
+	// The instruction that is running, which is charged with the ticks since
+	// last when the next one starts, or when bc_program_exec() returns.
+	uint64_t last;
+	size_t func;
+	uchar inst;
+	bool running;
+
+	BcProfFmt fmt;
+
+} BcProf;
+#endif // BC_PROG_PROFILE
+
 typedef struct BcProgram {
 
 	BcBigDig globals[BC_PROG_GLOBALS_LEN];
@@ -72,13 +165,13 @@ typedef struct BcProgram {
 	BcVec *strs;
 
 	BcVec fns;
-	BcVec fn_map;
+	BcMap fn_map;
 
 	BcVec vars;
-	BcVec var_map;
+	BcMap var_map;
 
 	BcVec arrs;
-	BcVec arr_map;
+	BcMap arr_map;
 
 #if DC_ENABLED
 	BcVec strs_v;
@@ -94,6 +187,15 @@ typedef struct BcProgram {
 
 #if BC_ENABLED
 	BcNum last;
+
+	BcVec lib_cache;
+	BcVec lib_pend;
+
+	BcPure pure;
+
+	// The positions of array parameters that may still share the contents
+	// of the array that was passed, one per parameter of each active call.
+	BcVec shared;
 #endif // BC_ENABLED
 
 #if DC_ENABLED
@@ -105,8 +207,37 @@ typedef struct BcProgram {
 	BcDig zero_num[BC_PROG_ONE_CAP];
 	BcDig one_num[BC_PROG_ONE_CAP];
 
+#if BC_PROG_PROFILE
+	// The profile, or NULL if not profiling.
+	BcProf *prof;
+#endif // BC_PROG_PROFILE
+
 } BcProgram;
 
+#if BC_ENABLED && !BC_ENABLE_LIBRARY
+// How much a program had at some point, and what its variables, arrays, and
+// globals were, so that it can be put back that way.
+typedef struct BcProgramSnap {
+
+	size_t fns;
+	size_t vars;
+	size_t arrs;
+
+	BcBigDig globals[BC_PROG_GLOBALS_LEN];
+
+	// One number for each variable and one array for each array.
+	BcVec nums;
+	BcVec arrays;
+
+	BcNum last;
+
+#if BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
+	BcRNGData rng;
+#endif // BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
+
+} BcProgramSnap;
+#endif // BC_ENABLED && !BC_ENABLE_LIBRARY
+
 #define BC_PROG_STACK(s, n) ((s)->len >= ((size_t) (n)))
 
 #define BC_PROG_GLOBAL_PTR(v) (bc_vec_top(v))
@@ -166,7 +297,16 @@ void bc_program_printStackDebug(BcProgram* p);
 size_t bc_program_search(BcProgram *p, const char* id, bool var);
 size_t bc_program_insertFunc(BcProgram *p, const char *name);
 void bc_program_reset(BcProgram *p);
+#if BC_ENABLED && !BC_ENABLE_LIBRARY
+void bc_program_snap(BcProgram *p, BcProgramSnap *s);
+void bc_program_snapFree(BcProgramSnap *s);
+void bc_program_restore(BcProgram *p, const BcProgramSnap *s);
+#endif // BC_ENABLED && !BC_ENABLE_LIBRARY
 void bc_program_exec(BcProgram *p);
+#if BC_PROG_PROFILE
+void bc_program_profile(BcProgram *p, BcProfFmt fmt);
+void bc_program_report(BcProgram *p);
+#endif // BC_PROG_PROFILE
 
 void bc_program_negate(BcResult *r, BcNum *n);
 void bc_program_not(BcResult *r, BcNum *n);
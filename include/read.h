@@ -52,8 +52,12 @@
 
 #define BC_READ_BIN_CHAR(c) (((c) < ' ' && !isspace((c))) || ((uchar) c) > '~')
 
+bool bc_read_binary(const char *buf, size_t size);
 BcStatus bc_read_line(BcVec *vec, const char *prompt);
 void bc_read_file(const char *path, char **buf);
+#ifndef _WIN32
+char* bc_read_map(const char *path, size_t *len);
+#endif // _WIN32
 BcStatus bc_read_chars(BcVec *vec, const char *prompt);
 bool bc_read_buf(BcVec *vec, char *buf, size_t *buf_len);
 
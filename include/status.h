@@ -175,6 +175,16 @@ typedef enum BcErr {
 #define BC_FALLTHROUGH
 #endif // defined(__clang__) || defined(__GNUC__)
 
+// Labels as values are used for threaded dispatch in bc_program_exec(). This
+// can be turned off with -DBC_HAS_COMPUTED_GOTO=0 to use a switch instead.
+#ifndef BC_HAS_COMPUTED_GOTO
+#if defined(__clang__) || defined(__GNUC__)
+#define BC_HAS_COMPUTED_GOTO (1)
+#else // defined(__clang__) || defined(__GNUC__)
+#define BC_HAS_COMPUTED_GOTO (0)
+#endif // defined(__clang__) || defined(__GNUC__)
+#endif // BC_HAS_COMPUTED_GOTO
+
 // Workarounds for AIX's POSIX incompatibility.
 #ifndef SIZE_MAX
 #define SIZE_MAX __SIZE_MAX__
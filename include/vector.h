@@ -45,8 +45,26 @@
 #define BC_VEC_INVALID_IDX (SIZE_MAX)
 #define BC_VEC_START_CAP (UINTMAX_C(1)<<5)
 
+// The number of bytes an index takes up in bytecode.
+#define BC_VEC_INDEX_SIZE (sizeof(size_t))
+
 typedef unsigned char uchar;
 
+// The offset basis and prime of FNV-1a for the width of size_t. Every hash
+// table uses bc_vec_hash(), starting from BC_VEC_HASH_INIT.
+#if SIZE_MAX > UINT32_MAX
+#define BC_VEC_HASH_INIT ((size_t) UINTMAX_C(14695981039346656037))
+#define BC_VEC_HASH_PRIME ((size_t) UINTMAX_C(1099511628211))
+#else // SIZE_MAX > UINT32_MAX
+#define BC_VEC_HASH_INIT ((size_t) UINT32_C(2166136261))
+#define BC_VEC_HASH_PRIME ((size_t) UINT32_C(16777619))
+#endif // SIZE_MAX > UINT32_MAX
+
+// Whether an open-addressed table with cap slots needs to grow before one
+// more entry goes in. Tables are kept at most 3/4 full so that probes stay
+// short.
+#define BC_VEC_HASH_FULL(used, cap) (((used) + 1) * 4 > (cap) * 3)
+
 typedef void (*BcVecFree)(void*);
 
 // Forward declaration.
@@ -60,7 +78,22 @@ typedef struct BcVec {
 	BcVecFree dtor;
 } BcVec;
 
+typedef struct BcMapSlot {
+	size_t hash;
+	size_t idx;
+} BcMapSlot;
+
+// A map from names to indices. The ids are in the order they were inserted,
+// and the slots are an open-addressed hash table of indices into them, where
+// an empty slot has an index of BC_VEC_INVALID_IDX.
+typedef struct BcMap {
+	BcVec ids;
+	BcMapSlot *slots;
+	size_t cap;
+} BcMap;
+
 void bc_vec_init(BcVec *restrict v, size_t esize, BcVecFree dtor);
+void bc_vec_initLazy(BcVec *restrict v, size_t esize, BcVecFree dtor);
 void bc_vec_expand(BcVec *restrict v, size_t req);
 void bc_vec_grow(BcVec *restrict v, size_t n);
 
@@ -86,17 +119,22 @@ void bc_vec_clear(BcVec *restrict v);
 
 void bc_vec_free(void *vec);
 
-bool bc_map_insert(BcVec *restrict v, const char *name,
+size_t bc_vec_hash(size_t h, const void *data, size_t len);
+
+void bc_map_init(BcMap *restrict m);
+#ifndef NDEBUG
+void bc_map_free(void *map);
+#endif // NDEBUG
+bool bc_map_insert(BcMap *restrict m, const char *name,
                    size_t idx, size_t *restrict i);
-size_t bc_map_index(const BcVec *restrict v, const char *name);
+size_t bc_map_index(const BcMap *restrict m, const char *name);
+#if BC_ENABLED && !BC_ENABLE_LIBRARY
+void bc_map_truncate(BcMap *restrict m, size_t len);
+#endif // BC_ENABLED && !BC_ENABLE_LIBRARY
 
 #define bc_vec_pop(v) (bc_vec_npop((v), 1))
 #define bc_vec_top(v) (bc_vec_item_rev((v), 0))
 
-#ifndef NDEBUG
-#define bc_map_init(v) (bc_vec_init((v), sizeof(BcId), bc_id_free))
-#else // NDEBUG
-#define bc_map_init(v) (bc_vec_init((v), sizeof(BcId), NULL))
-#endif // NDEBUG
+#define bc_map_item(m, i) ((BcId*) bc_vec_item(&(m)->ids, (i)))
 
 #endif // BC_VECTOR_H
@@ -60,6 +60,7 @@
 
 #if !BC_ENABLE_LIBRARY
 #include <file.h>
+#include <bytecode.h>
 #endif // !BC_ENABLE_LIBRARY
 
 #if !BC_ENABLED && !DC_ENABLED
@@ -112,6 +113,13 @@
 #define BC_FLAG_P (UINTMAX_C(1)<<6)
 #define BC_FLAG_TTYIN (UINTMAX_C(1)<<7)
 #define BC_FLAG_TTY (UINTMAX_C(1)<<8)
+
+#if BC_ENABLED
+#define BC_FLAG_N (UINTMAX_C(1)<<9)
+#endif // BC_ENABLED
+
+#define BC_FLAG_R (UINTMAX_C(1)<<10)
+
 #define BC_TTYIN (vm.flags & BC_FLAG_TTYIN)
 #define BC_TTY (vm.flags & BC_FLAG_TTY)
 
@@ -121,6 +129,7 @@
 #define BC_W (vm.flags & BC_FLAG_W)
 #define BC_L (vm.flags & BC_FLAG_L)
 #define BC_G (vm.flags & BC_FLAG_G)
+#define BC_N (vm.flags & BC_FLAG_N)
 
 #endif // BC_ENABLED
 
@@ -130,6 +139,7 @@
 
 #define BC_I (vm.flags & BC_FLAG_I)
 #define BC_P (vm.flags & BC_FLAG_P)
+#define BC_R (vm.flags & BC_FLAG_R)
 
 #if BC_ENABLED
 
@@ -271,12 +281,47 @@
 		vm.sig = 0;        \
 	} while (0)
 
+// bc can keep the parsed code of files in a directory, so that it does not
+// have to parse them again. The files are mapped into memory.
+#ifndef _WIN32
+#define BC_VM_CACHE (BC_ENABLED && !BC_ENABLE_LIBRARY)
+#else // _WIN32
+#define BC_VM_CACHE (0)
+#endif // _WIN32
+
+// bc can serve requests on a UNIX socket from one or more processes that each
+// keep a program, and the math library, loaded between requests. Batch mode
+// runs the lines of stdin the same way, one request per line.
+#ifndef _WIN32
+#define BC_VM_SERVER (BC_ENABLED && !BC_ENABLE_LIBRARY)
+#else // _WIN32
+#define BC_VM_SERVER (0)
+#endif // _WIN32
+
+#define BC_VM_JOBS_MAX (256)
+
+// How many lines of a batch are handed to a worker at a time.
+#define BC_VM_BATCH_LINES (256)
+
+// A batch worker sends its output and its errors back down one pipe, as
+// records that each start with two size_t's: what the record is and, for
+// output and errors, how many bytes follow. The record that ends a block has
+// the first error in the block instead.
+#define BC_VM_BATCH_OUT (0)
+#define BC_VM_BATCH_ERR (1)
+#define BC_VM_BATCH_END (2)
+
 #define BC_VM_BUF_SIZE (1<<12)
 #define BC_VM_STDOUT_BUF_SIZE (1<<11)
 #define BC_VM_STDERR_BUF_SIZE (1<<10)
 #define BC_VM_STDIN_BUF_SIZE (BC_VM_STDERR_BUF_SIZE - 1)
 
-#define BC_VM_SAFE_RESULT(r) ((r)->t >= BC_RESULT_TEMP)
+// Input that is not interactive is read this much at a time.
+#define BC_VM_STDIN_BLOCK_SIZE (1<<16)
+
+// Constants borrow their digits from the function, so they are not safe.
+#define BC_VM_SAFE_RESULT(r) \
+	((r)->t >= BC_RESULT_TEMP && (r)->t != BC_RESULT_CONST)
 
 #if BC_ENABLE_LIBRARY
 #define bc_vm_error(e, l, ...) (bc_vm_handleError((e)))
@@ -310,6 +355,37 @@
 #define BC_VM_FUNC_EXIT
 #endif // BC_DEBUG_CODE
 
+#if BC_VM_SERVER
+typedef struct BcVmServer {
+
+	// What the program had before the first request. Each request starts
+	// from it.
+	BcProgramSnap snap;
+
+	// The functions that the program had, saved to load them again when a
+	// request defines one of them again.
+	BcVec fns;
+	bool redef;
+
+	// The first error that a request ended with, which batch mode exits with.
+	BcStatus status;
+
+	// The workers, if this is the process that started them.
+	BcVec pids;
+
+	// Where requests come from: the listening socket, or stdin for a batch.
+	int in;
+
+	// Whether this process made the file for the socket.
+	bool bound;
+
+	// Whether this is a batch worker, which sends its output and errors back
+	// as records.
+	bool batch;
+
+} BcVmServer;
+#endif // BC_VM_SERVER
+
 typedef struct BcVm {
 
 	volatile sig_atomic_t status;
@@ -359,6 +435,25 @@ typedef struct BcVm {
 	bool eof;
 #endif // BC_ENABLE_LIBRARY
 
+#if BC_VM_CACHE
+	const char *cache_dir;
+
+	// Where the file being parsed is saved, or NULL if it cannot be.
+	BcBytecodeFile *cache;
+#endif // BC_VM_CACHE
+
+#if BC_VM_SERVER
+	const char *server_path;
+	bool batch;
+	size_t jobs;
+
+	// The running server, or NULL.
+	BcVmServer *server;
+
+	// Set by a signal, which stops the whole server and not just a request.
+	volatile sig_atomic_t server_quit;
+#endif // BC_VM_SERVER
+
 	BcBigDig maxes[BC_PROG_GLOBALS_LEN + BC_ENABLE_EXTRA_MATH];
 
 #if !BC_ENABLE_LIBRARY
@@ -409,6 +504,11 @@ typedef struct BcVm {
 
 	char *buf;
 	size_t buf_len;
+
+	// What the block reader for stdin has and has not run yet. read() takes
+	// its lines from here first.
+	const char *stdin_buf;
+	size_t stdin_len;
 #endif // !BC_ENABLE_LIBRARY
 
 } BcVm;
@@ -418,6 +518,9 @@ void bc_vm_boot(int argc, char *argv[], const char *env_len,
                 const char* const env_args);
 void bc_vm_init(void);
 void bc_vm_shutdown(void);
+#if BC_ENABLED && !BC_ENABLE_LIBRARY
+void bc_vm_compile(BcVec *lib, BcVec *lib2);
+#endif // BC_ENABLED && !BC_ENABLE_LIBRARY
 void bc_vm_freeTemps(void);
 
 void bc_vm_printf(const char *fmt, ...);
@@ -53,13 +53,21 @@ static const BcOptLong bc_args_lopt[] = {
 	{ "help", BC_OPT_NONE, 'h' },
 	{ "interactive", BC_OPT_NONE, 'i' },
 	{ "no-prompt", BC_OPT_NONE, 'P' },
+	{ "profile", BC_OPT_REQUIRED, 'p' },
+	{ "stream", BC_OPT_NONE, 'R' },
 #if BC_ENABLED
 	{ "global-stacks", BC_OPT_BC_ONLY, 'g' },
 	{ "mathlib", BC_OPT_BC_ONLY, 'l' },
+	{ "no-optimize", BC_OPT_BC_ONLY, 'n' },
 	{ "quiet", BC_OPT_BC_ONLY, 'q' },
 	{ "standard", BC_OPT_BC_ONLY, 's' },
 	{ "warn", BC_OPT_BC_ONLY, 'w' },
 #endif // BC_ENABLED
+#if BC_VM_SERVER
+	{ "batch", BC_OPT_BC_ONLY, 'B' },
+	{ "jobs", BC_OPT_REQUIRED_BC_ONLY, 'j' },
+	{ "server", BC_OPT_REQUIRED_BC_ONLY, 'S' },
+#endif // BC_VM_SERVER
 	{ "version", BC_OPT_NONE, 'v' },
 	{ "version", BC_OPT_NONE, 'V' },
 #if DC_ENABLED
@@ -89,6 +97,37 @@ static void bc_args_file(const char *file) {
 	free(buf);
 }
 
+static void bc_args_profile(const char *str) {
+
+	BcProfFmt fmt = BC_PROF_TEXT;
+
+	if (!strcmp(str, "text")) fmt = BC_PROF_TEXT;
+	else if (!strcmp(str, "json")) fmt = BC_PROF_JSON;
+	else if (!strcmp(str, "csv")) fmt = BC_PROF_CSV;
+	else bc_vm_verr(BC_ERR_FATAL_OPTION, "-p (--profile)");
+
+	bc_program_profile(&vm.prog, fmt);
+}
+
+#if BC_VM_SERVER
+static void bc_args_jobs(const char *str) {
+
+	size_t i, len = strlen(str);
+	int num;
+
+	for (num = len != 0, i = 0; num && i < len; ++i) num = isdigit(str[i]);
+
+	if (num) {
+		i = len <= 4 ? (size_t) atoi(str) : 0;
+		num = (i >= 1 && i <= BC_VM_JOBS_MAX);
+	}
+
+	if (BC_ERR(!num)) bc_vm_verr(BC_ERR_FATAL_OPTION, "-j (--jobs)");
+
+	vm.jobs = i;
+}
+#endif // BC_VM_SERVER
+
 void bc_args(int argc, char *argv[]) {
 
 	int c;
@@ -142,6 +181,18 @@ void bc_args(int argc, char *argv[]) {
 				break;
 			}
 
+			case 'p':
+			{
+				bc_args_profile(opts.optarg);
+				break;
+			}
+
+			case 'R':
+			{
+				vm.flags |= BC_FLAG_R;
+				break;
+			}
+
 #if BC_ENABLED
 			case 'g':
 			{
@@ -157,6 +208,13 @@ void bc_args(int argc, char *argv[]) {
 				break;
 			}
 
+			case 'n':
+			{
+				assert(BC_IS_BC);
+				vm.flags |= BC_FLAG_N;
+				break;
+			}
+
 			case 'q':
 			{
 				assert(BC_IS_BC);
@@ -179,6 +237,29 @@ void bc_args(int argc, char *argv[]) {
 			}
 #endif // BC_ENABLED
 
+#if BC_VM_SERVER
+			case 'B':
+			{
+				assert(BC_IS_BC);
+				vm.batch = true;
+				break;
+			}
+
+			case 'j':
+			{
+				assert(BC_IS_BC);
+				bc_args_jobs(opts.optarg);
+				break;
+			}
+
+			case 'S':
+			{
+				assert(BC_IS_BC);
+				vm.server_path = opts.optarg;
+				break;
+			}
+#endif // BC_VM_SERVER
+
 			case 'V':
 			case 'v':
 			{
@@ -211,6 +292,15 @@ void bc_args(int argc, char *argv[]) {
 	if (version) bc_vm_info(NULL);
 	if (do_exit) exit((int) vm.status);
 
+#if BC_VM_SERVER
+	// A server only runs what it is sent.
+	if (BC_ERR(vm.server_path != NULL &&
+	           (vm.batch || vm.exprs.len || opts.optind < (size_t) argc)))
+	{
+		bc_vm_verr(BC_ERR_FATAL_OPTION, "-S (--server)");
+	}
+#endif // BC_VM_SERVER
+
 	if (opts.optind < (size_t) argc && vm.files.v == NULL)
 		bc_vec_init(&vm.files, sizeof(char*), NULL);
 
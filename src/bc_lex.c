@@ -79,7 +79,10 @@ static void bc_lex_string(BcLex *l) {
 
 	l->t = BC_LEX_STR;
 
-	for (; (c = buf[i]) && c != '"'; ++i) nlines += c == '\n';
+	for (; (c = buf[i]) && c != '"'; ++i) {
+		if (BC_ERR(BC_LEX_BIN(l, c))) bc_lex_binary(l);
+		nlines += c == '\n';
+	}
 
 	if (BC_ERR(c == '\0')) {
 		l->i = i;
@@ -48,6 +48,7 @@
 
 static void bc_parse_else(BcParse *p);
 static void bc_parse_stmt(BcParse *p);
+static size_t bc_parse_instLen(uchar inst);
 static BcParseStatus bc_parse_expr_err(BcParse *p, uint8_t flags,
                                        BcParseNext next);
 
@@ -170,10 +171,22 @@ static void bc_parse_rightParen(BcParse *p, size_t *nexs) {
 	bc_lex_next(&p->l);
 }
 
+static bool bc_parse_isConst(const BcParse *p, size_t bgn) {
+
+	const BcVec *code = &p->func->code;
+	uchar inst = *((uchar*) bc_vec_item(code, bgn));
+
+	if (inst == BC_INST_ZERO || inst == BC_INST_ONE)
+		return code->len == bgn + 1;
+
+	return inst == BC_INST_NUM && code->len == bgn + 1 + BC_VEC_INDEX_SIZE;
+}
+
 static void bc_parse_params(BcParse *p, uint8_t flags) {
 
 	bool comma = false;
-	size_t nparams;
+	size_t nparams, bgn = p->func->code.len;
+	uchar inst = BC_INST_CALL;
 
 	bc_lex_next(&p->l);
 
@@ -189,7 +202,13 @@ static void bc_parse_params(BcParse *p, uint8_t flags) {
 	}
 
 	if (BC_ERR(comma)) bc_parse_err(p, BC_ERR_PARSE_TOKEN);
-	bc_parse_push(p, BC_INST_CALL);
+
+	// Library functions are pure, so calls from the library with one constant
+	// argument, like a(1), can have their results cached by the program.
+	if (p->lib && nparams == 1 && bc_parse_isConst(p, bgn))
+		inst = BC_INST_CALL_CONST;
+
+	bc_parse_push(p, inst);
 	bc_parse_pushIndex(p, nparams);
 }
 
@@ -220,7 +239,7 @@ static void bc_parse_call(BcParse *p, const char *name, uint8_t flags) {
 		// Make sure that this pointer was not invalidated.
 		p->func = bc_vec_item(&p->prog->fns, p->fidx);
 	}
-	else idx = ((BcId*) bc_vec_item(&p->prog->fn_map, idx))->idx;
+	else idx = bc_map_item(&p->prog->fn_map, idx)->idx;
 
 	bc_parse_pushIndex(p, idx);
 
@@ -496,9 +515,24 @@ static void bc_parse_return(BcParse *p) {
 	else {
 
 		BcParseStatus s;
+		size_t i, last, bgn = p->func->code.len;
+		uchar *code;
 
 		s = bc_parse_expr_err(p, BC_PARSE_NEEDVAL, bc_parse_next_expr);
 
+		code = (uchar*) p->func->code.v;
+
+		for (i = last = bgn; i < p->func->code.len;
+		     i += bc_parse_instLen(code[i]))
+		{
+			last = i;
+		}
+
+		// If the call is the last thing before returning, the program may be
+		// able to run the callee in place of this function.
+		if (last < p->func->code.len && code[last] == BC_INST_CALL)
+			code[last] = BC_INST_CALL_TAIL;
+
 		if (s == BC_PARSE_STATUS_EMPTY_EXPR) {
 			bc_parse_push(p, inst);
 			bc_lex_next(&p->l);
@@ -563,6 +597,7 @@ static void bc_parse_endBody(BcParse *p, bool brace) {
 		else if (BC_PARSE_FUNC_INNER(p)) {
 			BcInst inst = (p->func->voidfn ? BC_INST_RET_VOID : BC_INST_RET0);
 			bc_parse_push(p, inst);
+			bc_parse_optimize(p);
 			bc_parse_updateFunc(p, BC_PROG_MAIN);
 			bc_vec_pop(&p->flags);
 		}
@@ -774,7 +809,7 @@ static void bc_parse_loopExit(BcParse *p, BcLexType type) {
 
 static void bc_parse_func(BcParse *p) {
 
-	bool comma = false, voidfn;
+	bool comma = false, voidfn, pure;
 	uint16_t flags;
 	size_t idx;
 
@@ -785,20 +820,24 @@ static void bc_parse_func(BcParse *p) {
 
 	voidfn = (!BC_IS_POSIX && p->l.t == BC_LEX_NAME &&
 	          !strcmp(p->l.str.v, "void"));
+	pure = (!BC_IS_POSIX && p->l.t == BC_LEX_NAME &&
+	        !strcmp(p->l.str.v, "pure"));
 
 	bc_lex_next(&p->l);
 
 	voidfn = (voidfn && p->l.t == BC_LEX_NAME);
+	pure = (pure && p->l.t == BC_LEX_NAME);
 
 	if (voidfn) {
 		bc_parse_err(p, BC_ERR_POSIX_VOID);
 		bc_lex_next(&p->l);
 	}
+	else if (pure) bc_lex_next(&p->l);
 
 	if (BC_ERR(p->l.t != BC_LEX_LPAREN))
 		bc_parse_err(p, BC_ERR_PARSE_FUNC);
 
-	assert(p->prog->fns.len == p->prog->fn_map.len);
+	assert(p->prog->fns.len == p->prog->fn_map.ids.len);
 
 	BC_SIG_LOCK;
 
@@ -809,6 +848,8 @@ static void bc_parse_func(BcParse *p) {
 	assert(idx);
 	bc_parse_updateFunc(p, idx);
 	p->func->voidfn = voidfn;
+	p->func->pure = pure;
+	p->func->lib = p->lib;
 
 	bc_lex_next(&p->l);
 
@@ -845,6 +886,10 @@ static void bc_parse_func(BcParse *p) {
 		else if (BC_ERR(t == BC_TYPE_REF))
 			bc_parse_verr(p, BC_ERR_PARSE_REF_VAR, p->buf.v);
 
+		// The cache of a pure function is keyed by numbers only.
+		if (BC_ERR(pure && t != BC_TYPE_VAR))
+			bc_parse_err(p, BC_ERR_PARSE_FUNC);
+
 		comma = (p->l.t == BC_LEX_COMMA);
 		if (comma) {
 			bc_lex_next(&p->l);
@@ -1098,6 +1143,11 @@ static void bc_parse_stmt(BcParse *p) {
 			bc_vm_printf("MAX Exponent     = %lu\n", BC_MAX_EXP);
 			bc_vm_printf("Number of vars   = %lu\n", BC_MAX_VARS);
 
+#if BC_VM_CACHE
+			// Saved code would not print this.
+			vm.cache = NULL;
+#endif // BC_VM_CACHE
+
 			bc_lex_next(&p->l);
 
 			break;
@@ -1114,6 +1164,11 @@ static void bc_parse_stmt(BcParse *p) {
 			// Quit is a compile-time command. We don't exit directly,
 			// so the vm can clean up. Limits do the same thing.
 			vm.status = BC_STATUS_QUIT;
+
+#if BC_VM_CACHE
+			if (vm.cache != NULL) vm.cache->quit = true;
+#endif // BC_VM_CACHE
+
 			BC_VM_JMP;
 			break;
 		}
@@ -1410,6 +1465,16 @@ static BcParseStatus bc_parse_expr_err(BcParse *p, uint8_t flags,
 				else if (t == BC_LEX_KW_READ && BC_ERR(flags & BC_PARSE_NOREAD))
 					bc_parse_err(p, BC_ERR_EXEC_REC_READ);
 				else {
+
+#if BC_VM_CACHE
+					// Parsing what read() reads can add names, so from now on,
+					// saved code may not be at the same indices.
+					if (t == BC_LEX_KW_READ) {
+						vm.cache_dir = NULL;
+						vm.cache = NULL;
+					}
+#endif // BC_VM_CACHE
+
 					prev = t - BC_LEX_KW_READ + BC_INST_READ;
 					bc_parse_noArgBuiltin(p, prev);
 				}
@@ -1529,4 +1594,560 @@ void bc_parse_expr(BcParse *p, uint8_t flags) {
 	assert(p);
 	bc_parse_expr_status(p, flags, bc_parse_next_read);
 }
+
+static size_t bc_parse_instLen(uchar inst) {
+
+	if (inst == BC_INST_JUMP_VAR_NUM) return 2 + 3 * BC_VEC_INDEX_SIZE;
+	if (inst == BC_INST_ASSIGN_VAR) return 2 + 2 * BC_VEC_INDEX_SIZE;
+
+	if (inst == BC_INST_CALL || inst == BC_INST_CALL_CONST ||
+	    inst == BC_INST_CALL_TAIL)
+	{
+		return 1 + 2 * BC_VEC_INDEX_SIZE;
+	}
+
+	if (inst == BC_INST_NUM || inst == BC_INST_VAR ||
+	    inst == BC_INST_ARRAY_ELEM || inst == BC_INST_ARRAY ||
+	    inst == BC_INST_STR || inst == BC_INST_JUMP ||
+	    inst == BC_INST_JUMP_ZERO || inst == BC_INST_INC_VAR ||
+	    inst == BC_INST_DEC_VAR)
+	{
+		return 1 + BC_VEC_INDEX_SIZE;
+	}
+
+	return 1;
+}
+
+static size_t bc_parse_optIndex(const BcVec *code, size_t i) {
+	size_t idx;
+	memcpy(&idx, bc_vec_item(code, i + 1), BC_VEC_INDEX_SIZE);
+	return idx;
+}
+
+static bool bc_parse_optTarget(const BcParse *p, size_t start, size_t i) {
+	uchar *marks = (uchar*) p->buf.v;
+	return (marks[i - start] & BC_PARSE_OPT_TARGET) != 0;
+}
+
+static void bc_parse_optTargets(BcParse *p, size_t start) {
+
+	BcFunc *f = p->func;
+	size_t i, len = f->code.len - start + 1;
+	uchar *marks;
+
+	bc_vec_npop(&p->buf, p->buf.len);
+	bc_vec_expand(&p->buf, len);
+	memset(p->buf.v, 0, len);
+	p->buf.len = len;
+
+	marks = (uchar*) p->buf.v;
+
+	for (i = 0; i < f->labels.len; ++i) {
+		size_t addr = *((size_t*) bc_vec_item(&f->labels, i));
+		if (addr != SIZE_MAX && addr >= start)
+			marks[addr - start] |= BC_PARSE_OPT_TARGET;
+	}
+}
+
+static void bc_parse_optJumps(BcParse *p, size_t start) {
+
+	BcFunc *f = p->func;
+	char *code = f->code.v;
+	size_t i, n;
+
+	for (i = start; i < f->code.len; i += bc_parse_instLen((uchar) code[i])) {
+
+		uchar inst = (uchar) code[i];
+		size_t idx, addr;
+
+		if (inst != BC_INST_JUMP && inst != BC_INST_JUMP_ZERO) continue;
+
+		idx = bc_parse_optIndex(&f->code, i);
+
+		// Jumps that land on a jump can go straight to where that one goes.
+		// Loops can jump to themselves, so this does not go on forever.
+		for (n = 0; n < f->labels.len; ++n) {
+
+			addr = *((size_t*) bc_vec_item(&f->labels, idx));
+
+			if (addr == SIZE_MAX || addr < start || addr >= f->code.len ||
+			    (uchar) code[addr] != BC_INST_JUMP)
+			{
+				break;
+			}
+
+			idx = bc_parse_optIndex(&f->code, addr);
+		}
+
+		memcpy(code + i + 1, &idx, BC_VEC_INDEX_SIZE);
+	}
+}
+
+static void bc_parse_foldEnd(BcParse *p, size_t start,
+                             BcParseFold *folds, size_t *n)
+{
+	uchar *marks = (uchar*) p->buf.v;
+	size_t i;
+
+	for (i = 0; i < *n; ++i) {
+		if (folds[i].kind & BC_PARSE_FOLD_OPS) {
+			marks[folds[i].start - start] |= BC_PARSE_OPT_FOLD;
+			marks[folds[i].last - start] |= BC_PARSE_OPT_FOLD_END;
+		}
+	}
+
+	*n = 0;
+}
+
+static uchar bc_parse_foldLeaf(const BcFunc *f, size_t i) {
+
+	uchar inst = *((uchar*) bc_vec_item(&f->code, i));
+	uchar kind = BC_PARSE_FOLD_LIT | BC_PARSE_FOLD_INT;
+	BcConst *c;
+
+	if (inst == BC_INST_ZERO) return kind;
+	if (inst == BC_INST_ONE) return kind | BC_PARSE_FOLD_NONZERO;
+	if (inst != BC_INST_NUM) return 0;
+
+	c = bc_vec_item(&f->consts, bc_parse_optIndex(&f->code, i));
+
+	if (c->fold) return 0;
+
+	// Whether a constant has a radix point, or a digit that is not zero, is
+	// the same in every ibase.
+	if (strchr(c->val, '.') != NULL) kind &= ~(BC_PARSE_FOLD_INT);
+	if (strspn(c->val, "0.") != strlen(c->val)) kind |= BC_PARSE_FOLD_NONZERO;
+
+	return kind;
+}
+
+static void bc_parse_foldScan(BcParse *p, size_t start) {
+
+	BcFunc *f = p->func;
+	const char *code = f->code.v;
+	BcParseFold folds[BC_PARSE_FOLD_MAX];
+	size_t i, n = 0;
+
+	for (i = start; i < f->code.len; i += bc_parse_instLen((uchar) code[i])) {
+
+		uchar a, b, kind, inst = (uchar) code[i];
+		bool fold;
+
+		// Jumping into the middle of a folded expression would not work.
+		if (bc_parse_optTarget(p, start, i)) bc_parse_foldEnd(p, start, folds, &n);
+
+		kind = bc_parse_foldLeaf(f, i);
+
+		if (kind) {
+
+			if (n == BC_PARSE_FOLD_MAX) bc_parse_foldEnd(p, start, folds, &n);
+
+			folds[n].start = folds[n].last = i;
+			folds[n].kind = kind;
+			n += 1;
+
+			continue;
+		}
+
+		// Each expression being folded ends right where the next one starts,
+		// and the last one ends right here, so an operator applies to the
+		// expressions on top.
+		if (inst == BC_INST_NEG && n) {
+			kind = folds[n - 1].kind;
+			folds[n - 1].kind = (kind & ~(BC_PARSE_FOLD_LIT)) | BC_PARSE_FOLD_OPS;
+			folds[n - 1].last = i;
+			continue;
+		}
+
+		if (n < 2) {
+			bc_parse_foldEnd(p, start, folds, &n);
+			continue;
+		}
+
+		a = folds[n - 2].kind;
+		b = folds[n - 1].kind;
+
+		// Only operations whose results do not depend on scale can be folded.
+		// Addition and subtraction never do. Multiplication does not if one
+		// side is an integer. Powers do not if they are of nonzero integers,
+		// and the exponent is a plain constant, which cannot be negative.
+		switch (inst) {
+
+			case BC_INST_PLUS:
+			case BC_INST_MINUS:
+			{
+				fold = true;
+				kind = a & b & BC_PARSE_FOLD_INT;
+				break;
+			}
+
+			case BC_INST_MULTIPLY:
+			{
+				fold = (((a | b) & BC_PARSE_FOLD_INT) != 0);
+				kind = a & b & (BC_PARSE_FOLD_INT | BC_PARSE_FOLD_NONZERO);
+				break;
+			}
+
+			case BC_INST_POWER:
+			{
+				uchar base = BC_PARSE_FOLD_INT | BC_PARSE_FOLD_NONZERO;
+				uchar exp = BC_PARSE_FOLD_INT | BC_PARSE_FOLD_LIT;
+
+				fold = ((a & base) == base && (b & exp) == exp);
+				kind = base;
+				break;
+			}
+
+			default:
+			{
+				fold = false;
+				kind = 0;
+				break;
+			}
+		}
+
+		if (fold) {
+			n -= 1;
+			folds[n - 1].kind = kind | BC_PARSE_FOLD_OPS;
+			folds[n - 1].last = i;
+		}
+		else bc_parse_foldEnd(p, start, folds, &n);
+	}
+
+	bc_parse_foldEnd(p, start, folds, &n);
+}
+
+static size_t bc_parse_addFold(BcParse *p, const char *code, size_t len) {
+
+	BcVec *consts = &p->func->consts;
+	size_t i, idx = consts->len;
+	BcConst c;
+
+	BC_SIG_ASSERT_LOCKED;
+
+	c.val = bc_vm_malloc(len);
+	memcpy(c.val, code, len);
+	c.fold = len;
+	c.nbases = 0;
+
+	for (i = 0; i < BC_CONST_BASES; ++i) bc_num_clear(c.nums + i);
+
+	bc_vec_push(consts, &c);
+
+	return idx;
+}
+
+static void bc_parse_optSkip(BcParse *p, size_t n) {
+
+	size_t i, len = p->opt.len;
+
+	for (i = 0; i < n; ++i) bc_vec_push(&p->offs, &len);
+}
+
+static bool bc_parse_optPure(const BcFunc *f, uchar inst, size_t i) {
+
+	if (inst == BC_INST_NUM) {
+		BcConst *c = bc_vec_item(&f->consts, bc_parse_optIndex(&f->code, i));
+		return !c->fold;
+	}
+
+	return inst == BC_INST_VAR || inst == BC_INST_ZERO ||
+	       inst == BC_INST_ONE || inst == BC_INST_STR;
+}
+
+static size_t bc_parse_optCompound(const BcParse *p, size_t start, size_t i,
+                                   uchar *inst)
+{
+	const BcFunc *f = p->func;
+	const char *code = f->code.v;
+	size_t j, len = f->code.len;
+	uchar op, assign;
+
+	j = i + 1 + BC_VEC_INDEX_SIZE;
+
+	if (j >= len || (uchar) code[j] != BC_INST_VAR ||
+	    bc_parse_optIndex(&f->code, i) != bc_parse_optIndex(&f->code, j) ||
+	    bc_parse_optTarget(p, start, j))
+	{
+		return 0;
+	}
+
+	j += 1 + BC_VEC_INDEX_SIZE;
+
+	if (j >= len || !bc_parse_optPure(f, (uchar) code[j], j) ||
+	    (uchar) code[j] == BC_INST_STR || bc_parse_optTarget(p, start, j))
+	{
+		return 0;
+	}
+
+	j += bc_parse_instLen((uchar) code[j]);
+
+	if (j + 1 >= len || bc_parse_optTarget(p, start, j) ||
+	    bc_parse_optTarget(p, start, j + 1))
+	{
+		return 0;
+	}
+
+	op = (uchar) code[j];
+	assign = (uchar) code[j + 1];
+
+	// The binary operators are in the same order as their assignments.
+	if (op < BC_INST_POWER ||
+	    op - BC_INST_POWER >= BC_INST_ASSIGN - BC_INST_ASSIGN_POWER ||
+	    (assign != BC_INST_ASSIGN && assign != BC_INST_ASSIGN_NO_VAL))
+	{
+		return 0;
+	}
+
+	*inst = (uchar) (op - BC_INST_POWER + BC_INST_ASSIGN_POWER);
+
+	if (assign == BC_INST_ASSIGN_NO_VAL)
+		*inst += (BC_INST_ASSIGN_POWER_NO_VAL - BC_INST_ASSIGN_POWER);
+
+	return j + 2;
+}
+
+static void bc_parse_optCommit(BcParse *p, size_t start) {
+
+	BcFunc *f = p->func;
+	size_t i;
+
+	bc_parse_optSkip(p, 1);
+
+	bc_vec_npop(&f->code, f->code.len - start);
+	bc_vec_npush(&f->code, p->opt.len, p->opt.v);
+
+	for (i = 0; i < f->labels.len; ++i) {
+
+		size_t *addr = bc_vec_item(&f->labels, i);
+
+		if (*addr != SIZE_MAX && *addr >= start)
+			*addr = start + *((size_t*) bc_vec_item(&p->offs, *addr - start));
+	}
+}
+
+static void bc_parse_optRewrite(BcParse *p, size_t start) {
+
+	BcFunc *f = p->func;
+	const char *code = f->code.v;
+	uchar *marks = (uchar*) p->buf.v;
+	size_t i, j, k, idx, len = f->code.len;
+	uchar inst;
+
+	bc_vec_npop(&p->opt, p->opt.len);
+	bc_vec_npop(&p->offs, p->offs.len);
+
+	for (i = start; i < len; i = j) {
+
+		inst = (uchar) code[i];
+		j = i + bc_parse_instLen(inst);
+
+		if (marks[i - start] & BC_PARSE_OPT_FOLD) {
+
+			for (k = i; !(marks[k - start] & BC_PARSE_OPT_FOLD_END);
+			     k += bc_parse_instLen((uchar) code[k]));
+
+			j = k + bc_parse_instLen((uchar) code[k]);
+			idx = bc_parse_addFold(p, code + i, j - i);
+
+			bc_parse_optSkip(p, j - i);
+			bc_vec_pushByte(&p->opt, BC_INST_NUM);
+			bc_vec_pushIndex(&p->opt, idx);
+
+			continue;
+		}
+
+		// A value that is popped right away does not need to be pushed, and an
+		// assignment whose value is popped does not need to make one.
+		if (j < len && (uchar) code[j] == BC_INST_POP &&
+		    !bc_parse_optTarget(p, start, j))
+		{
+			if (bc_parse_optPure(f, inst, i)) {
+				j += 1;
+				bc_parse_optSkip(p, j - i);
+				continue;
+			}
+
+			if (inst >= BC_INST_ASSIGN_POWER && inst <= BC_INST_ASSIGN) {
+				j += 1;
+				bc_parse_optSkip(p, j - i);
+				inst += (BC_INST_ASSIGN_POWER_NO_VAL - BC_INST_ASSIGN_POWER);
+				bc_vec_pushByte(&p->opt, inst);
+				continue;
+			}
+		}
+
+		// x = x op y is the same as x op= y when y is a single operand.
+		if (inst == BC_INST_VAR && (k = bc_parse_optCompound(p, start, i, &inst))) {
+
+			size_t leaf = j + 1 + BC_VEC_INDEX_SIZE;
+			size_t leaf_len = bc_parse_instLen((uchar) code[leaf]);
+
+			bc_parse_optSkip(p, k - i);
+			bc_vec_npush(&p->opt, j - i, code + i);
+			bc_vec_npush(&p->opt, leaf_len, code + leaf);
+			bc_vec_pushByte(&p->opt, inst);
+
+			j = k;
+
+			continue;
+		}
+
+		// Jumps to the next instruction do nothing.
+		if (inst == BC_INST_JUMP) {
+
+			size_t *addr = bc_vec_item(&f->labels, bc_parse_optIndex(&f->code, i));
+
+			if (*addr == j) {
+				bc_parse_optSkip(p, j - i);
+				continue;
+			}
+		}
+
+		bc_parse_optSkip(p, j - i);
+		bc_vec_npush(&p->opt, j - i, code + i);
+	}
+
+	bc_parse_optCommit(p, start);
+}
+
+static size_t bc_parse_optFusable(const BcParse *p, size_t start, size_t i,
+                                  size_t n)
+{
+	const BcFunc *f = p->func;
+	size_t j, end = i;
+
+	// A sequence can only be fused if nothing jumps into the middle of it.
+	for (j = 0; j < n; ++j) {
+
+		if (end >= f->code.len || (j && bc_parse_optTarget(p, start, end)))
+			return 0;
+
+		end += bc_parse_instLen(*((uchar*) bc_vec_item(&f->code, end)));
+	}
+
+	return end;
+}
+
+static void bc_parse_optFuse(BcParse *p, size_t start) {
+
+	BcFunc *f = p->func;
+	const char *code = f->code.v;
+	size_t i, j, a, b, len = f->code.len;
+	uchar inst, next, op;
+
+	bc_vec_npop(&p->opt, p->opt.len);
+	bc_vec_npop(&p->offs, p->offs.len);
+
+	for (i = start; i < len; i = j) {
+
+		inst = (uchar) code[i];
+		j = i + bc_parse_instLen(inst);
+
+		if (inst != BC_INST_VAR || j >= len) {
+			bc_parse_optSkip(p, j - i);
+			bc_vec_npush(&p->opt, j - i, code + i);
+			continue;
+		}
+
+		a = bc_parse_optIndex(&f->code, i);
+		next = (uchar) code[j];
+
+		// VAR ONE ASSIGN_PLUS_NO_VAL is what "++i" and "i += 1" become.
+		if (next == BC_INST_ONE && (b = bc_parse_optFusable(p, start, i, 3))) {
+
+			op = (uchar) code[j + 1];
+
+			if (op == BC_INST_ASSIGN_PLUS_NO_VAL ||
+			    op == BC_INST_ASSIGN_MINUS_NO_VAL)
+			{
+				bc_parse_optSkip(p, b - i);
+				bc_vec_pushByte(&p->opt, (uchar) (BC_INST_INC_VAR +
+				                (op != BC_INST_ASSIGN_PLUS_NO_VAL)));
+				bc_vec_pushIndex(&p->opt, a);
+				j = b;
+				continue;
+			}
+		}
+
+		// VAR VAR ASSIGN_*_NO_VAL is what "x = y" and "x = x op y" become.
+		if (next == BC_INST_VAR && (b = bc_parse_optFusable(p, start, i, 3))) {
+
+			op = (uchar) code[j + 1 + BC_VEC_INDEX_SIZE];
+
+			if (op >= BC_INST_ASSIGN_POWER_NO_VAL &&
+			    op <= BC_INST_ASSIGN_NO_VAL)
+			{
+				bc_parse_optSkip(p, b - i);
+				bc_vec_pushByte(&p->opt, BC_INST_ASSIGN_VAR);
+				bc_vec_pushByte(&p->opt, op);
+				bc_vec_pushIndex(&p->opt, a);
+				bc_vec_pushIndex(&p->opt, bc_parse_optIndex(&f->code, j));
+				j = b;
+				continue;
+			}
+		}
+
+		// VAR NUM REL_* JUMP_ZERO is what most loop and if conditions become.
+		if (next == BC_INST_NUM && (b = bc_parse_optFusable(p, start, i, 4))) {
+
+			size_t rel = j + 1 + BC_VEC_INDEX_SIZE;
+
+			op = (uchar) code[rel];
+
+			if (op >= BC_INST_REL_EQ && op <= BC_INST_REL_GT &&
+			    (uchar) code[rel + 1] == BC_INST_JUMP_ZERO)
+			{
+				bc_parse_optSkip(p, b - i);
+				bc_vec_pushByte(&p->opt, BC_INST_JUMP_VAR_NUM);
+				bc_vec_pushByte(&p->opt, op);
+				bc_vec_pushIndex(&p->opt, a);
+				bc_vec_pushIndex(&p->opt, bc_parse_optIndex(&f->code, j));
+				bc_vec_pushIndex(&p->opt, bc_parse_optIndex(&f->code, rel + 1));
+				j = b;
+				continue;
+			}
+		}
+
+		bc_parse_optSkip(p, j - i);
+		bc_vec_npush(&p->opt, j - i, code + i);
+	}
+
+	bc_parse_optCommit(p, start);
+}
+
+void bc_parse_optimize(BcParse *p) {
+
+	size_t start = 0;
+
+	if (BC_N) return;
+
+	BC_SIG_LOCK;
+
+	bc_parse_updateFunc(p, p->fidx);
+
+	// Main runs as it is parsed, so only the code it has not run yet can be
+	// changed.
+	if (p->fidx == BC_PROG_MAIN) {
+		BcInstPtr *ip = bc_vec_item(&p->prog->stack, 0);
+		start = ip->idx;
+	}
+
+	if (start < p->func->code.len) {
+
+		bc_parse_optTargets(p, start);
+		bc_parse_optJumps(p, start);
+		bc_parse_foldScan(p, start);
+		bc_parse_optRewrite(p, start);
+
+		// Fusing works on the rewritten code, which has new jump targets.
+		bc_parse_optTargets(p, start);
+		bc_parse_optFuse(p, start);
+
+		// The marks were kept in the name buffer, which must be a string.
+		bc_vec_npop(&p->buf, p->buf.len);
+	}
+
+	BC_SIG_UNLOCK;
+}
 #endif // BC_ENABLED
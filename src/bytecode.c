@@ -0,0 +1,932 @@
+/*
+ * *****************************************************************************
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2018-2020 Gavin D. Howard and contributors.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * *****************************************************************************
+ *
+ * Code for saving and loading parsed bc code.
+ *
+ * Saved code is native: sizes and indices are stored as size_t, and code is
+ * stored as the interpreter runs it. It is only meant to be loaded by the same
+ * build of bc that saved it, and the header makes sure that it is.
+ *
+ */
+
+#if BC_ENABLED
+
+#include <assert.h>
+#include <string.h>
+
+#include <bytecode.h>
+#include <lang.h>
+#include <vm.h>
+
+// The magic, the build, the key, the checksum, and whether the file ended at
+// quit.
+#define BC_BYTECODE_FILE_HEADER \
+	(BC_BYTECODE_FILE_MAGIC_LEN + BC_BYTECODE_BUILD_LEN + sizeof(size_t) + \
+	 4 * sizeof(uint64_t) + 1)
+
+#if BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
+#define BC_BYTECODE_RAND (1)
+#else // BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
+#define BC_BYTECODE_RAND (0)
+#endif // BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
+
+// Instructions are numbered differently with different features, and constants
+// are folded into limbs, so code is only loaded by the same kind of build.
+static void bc_bytecode_build(uchar build[BC_BYTECODE_BUILD_LEN]) {
+	build[0] = BC_BYTECODE_VERSION;
+	build[1] = (uchar) sizeof(size_t);
+	build[2] = (uchar) BC_INST_COUNT;
+	build[3] = (uchar) BC_BASE_DIGS;
+	build[4] = (uchar) (BC_ENABLE_EXTRA_MATH | BC_BYTECODE_RAND << 1 |
+	                    DC_ENABLED << 2);
+}
+
+#ifdef __SIZEOF_INT128__
+// GCC and Clang have a 128-bit integer, which makes the digest much faster.
+__extension__ typedef unsigned __int128 BcBytecodeU128;
+#endif // __SIZEOF_INT128__
+
+// FNV-1a with 128 bits, kept in two halves, high first, since C99 has nothing
+// wider than 64. The prime is 2^88 + 0x13b.
+static void bc_bytecode_digest(uint64_t h[2], const void *data, size_t len) {
+
+	const uchar *bytes = (const uchar*) data;
+	size_t i;
+
+#ifdef __SIZEOF_INT128__
+	BcBytecodeU128 x = (BcBytecodeU128) h[0] << 64 | h[1];
+	const BcBytecodeU128 prime = (BcBytecodeU128) 1 << 88 | 0x13b;
+
+	for (i = 0; i < len; ++i) {
+		x ^= bytes[i];
+		x *= prime;
+	}
+
+	h[0] = (uint64_t) (x >> 64);
+	h[1] = (uint64_t) x;
+#else // __SIZEOF_INT128__
+	for (i = 0; i < len; ++i) {
+
+		uint64_t carry;
+
+		h[1] ^= bytes[i];
+
+		// The high half of h[1] * 0x13b.
+		carry = ((h[1] >> 32) * 0x13b +
+		         ((h[1] & UINT64_C(0xffffffff)) * 0x13b >> 32)) >> 32;
+
+		h[0] = h[0] * 0x13b + (h[1] << 24) + carry;
+		h[1] *= 0x13b;
+	}
+#endif // __SIZEOF_INT128__
+}
+
+static void bc_bytecode_digestInit(uint64_t h[2]) {
+	h[0] = UINT64_C(0x6c62272e07bb0142);
+	h[1] = UINT64_C(0x62b821756295c58d);
+}
+
+static void bc_bytecode_size(BcVec *out, size_t n) {
+	bc_vec_npush(out, sizeof(size_t), &n);
+}
+
+static void bc_bytecode_bytes(BcVec *out, const void *data, size_t len) {
+	bc_bytecode_size(out, len);
+	if (len) bc_vec_npush(out, len, data);
+}
+
+static void bc_bytecode_vec(BcVec *out, const BcVec *v, size_t start) {
+	size_t len = v->size * (v->len - start);
+	bc_bytecode_bytes(out, len ? v->v + v->size * start : NULL, len);
+}
+
+static void bc_bytecode_header(BcVec *out, const BcBytecodeMark *m) {
+
+	uchar build[BC_BYTECODE_BUILD_LEN];
+
+	bc_bytecode_build(build);
+
+	bc_vec_npush(out, BC_BYTECODE_MAGIC_LEN, BC_BYTECODE_MAGIC);
+	bc_vec_npush(out, BC_BYTECODE_BUILD_LEN, build);
+
+	// Different versions number instructions differently.
+	bc_bytecode_bytes(out, BC_VERSION, sizeof(BC_VERSION));
+
+	bc_vec_npush(out, sizeof(BcBytecodeMark), m);
+}
+
+static void bc_bytecode_saveNames(BcVec *out, const BcMap *map, size_t start) {
+
+	size_t i;
+
+	bc_bytecode_size(out, map->ids.len - start);
+
+	for (i = start; i < map->ids.len; ++i) {
+		const char *name = bc_map_item(map, i)->name;
+		bc_bytecode_bytes(out, name, strlen(name) + 1);
+	}
+}
+
+static void bc_bytecode_saveConsts(BcVec *out, const BcVec *consts,
+                                   size_t start)
+{
+	size_t i;
+
+	bc_bytecode_size(out, consts->len - start);
+
+	for (i = start; i < consts->len; ++i) {
+
+		const BcConst *c = bc_vec_item(consts, i);
+
+		// A folded constant holds code, not a string.
+		bc_bytecode_size(out, c->fold);
+		bc_bytecode_bytes(out, c->val, c->fold ? c->fold : strlen(c->val) + 1);
+	}
+}
+
+static void bc_bytecode_saveStrs(BcVec *out, const BcVec *strs, size_t start) {
+
+	size_t i;
+
+	bc_bytecode_size(out, strs->len - start);
+
+	for (i = start; i < strs->len; ++i) {
+		const char *str = *((char**) bc_vec_item(strs, i));
+		bc_bytecode_bytes(out, str, strlen(str) + 1);
+	}
+}
+
+static void bc_bytecode_saveFunc(BcVec *out, const BcFunc *f) {
+
+	uchar flags = (uchar) (f->voidfn | f->pure << 1 | f->lib << 2);
+
+	bc_bytecode_bytes(out, f->name, strlen(f->name) + 1);
+
+	// A function that was never loaded is still saved the same way.
+	if (f->saved != NULL) {
+		bc_vec_npush(out, f->saved_len, f->saved);
+		return;
+	}
+
+	bc_bytecode_vec(out, &f->code, 0);
+	bc_bytecode_vec(out, &f->labels, 0);
+	bc_bytecode_vec(out, &f->autos, 0);
+	bc_bytecode_size(out, f->nparams);
+	bc_vec_pushByte(out, flags);
+	bc_bytecode_saveConsts(out, &f->consts, 0);
+	bc_bytecode_saveStrs(out, &f->strs, 0);
+}
+
+void bc_bytecode_mark(const BcProgram *p, BcBytecodeMark *m) {
+
+	const BcFunc *f = bc_vec_item(&p->fns, BC_PROG_MAIN);
+
+	m->fns = p->fns.len;
+	m->vars = p->vars.len;
+	m->arrs = p->arrs.len;
+	m->code = f->code.len;
+	m->labels = f->labels.len;
+	m->consts = f->consts.len;
+	m->strs = f->strs.len;
+}
+
+void bc_bytecode_save(const BcProgram *p, const BcBytecodeMark *m,
+                      const BcVec *redefs, BcVec *out)
+{
+	const BcFunc *f = bc_vec_item(&p->fns, BC_PROG_MAIN);
+	size_t i, n;
+
+	assert(out->size == sizeof(uchar));
+
+	bc_bytecode_header(out, m);
+
+	bc_bytecode_saveNames(out, &p->var_map, m->vars);
+	bc_bytecode_saveNames(out, &p->arr_map, m->arrs);
+
+	bc_bytecode_size(out, p->fns.len - m->fns);
+
+	for (i = m->fns; i < p->fns.len; ++i)
+		bc_bytecode_saveFunc(out, bc_vec_item(&p->fns, i));
+
+	n = redefs != NULL ? redefs->len : 0;
+
+	bc_bytecode_size(out, n);
+
+	for (i = 0; i < n; ++i) {
+		size_t idx = *((size_t*) bc_vec_item(redefs, i));
+		bc_bytecode_saveFunc(out, bc_vec_item(&p->fns, idx));
+	}
+
+	// Code outside of functions is added to main.
+	bc_bytecode_vec(out, &f->code, m->code);
+	bc_bytecode_vec(out, &f->labels, m->labels);
+	bc_bytecode_saveConsts(out, &f->consts, m->consts);
+	bc_bytecode_saveStrs(out, &f->strs, m->strs);
+}
+
+static bool bc_bytecode_get(BcBytecodeReader *r, void *data, size_t len) {
+
+	if (r->len - r->i < len) return false;
+
+	if (data != NULL) memcpy(data, r->buf + r->i, len);
+	r->i += len;
+
+	return true;
+}
+
+static const char* bc_bytecode_getBytes(BcBytecodeReader *r, size_t *len,
+                                        size_t size)
+{
+	const char *ptr;
+
+	if (!bc_bytecode_get(r, len, sizeof(size_t)) || *len % size) return NULL;
+
+	ptr = r->buf + r->i;
+
+	return bc_bytecode_get(r, NULL, *len) ? ptr : NULL;
+}
+
+static const char* bc_bytecode_getStr(BcBytecodeReader *r) {
+
+	size_t len;
+	const char *str = bc_bytecode_getBytes(r, &len, sizeof(uchar));
+
+	if (str == NULL || !len || memchr(str, '\0', len) != str + len - 1)
+		return NULL;
+
+	return str;
+}
+
+// The operands that follow an instruction, one letter each: an index of a
+// label, variable, array, constant, string, or function, any index (n), or a
+// byte with the operator of a fused instruction (r or o). An instruction that
+// bc cannot run gets NULL.
+static const char* bc_bytecode_operands(uchar inst) {
+
+	switch (inst) {
+
+		case BC_INST_JUMP:
+		case BC_INST_JUMP_ZERO:
+		{
+			return "l";
+		}
+
+		case BC_INST_JUMP_VAR_NUM:
+		{
+			return "rvcl";
+		}
+
+		case BC_INST_ASSIGN_VAR:
+		{
+			return "ovv";
+		}
+
+		case BC_INST_CALL:
+		case BC_INST_CALL_CONST:
+		case BC_INST_CALL_TAIL:
+		{
+			return "nf";
+		}
+
+		case BC_INST_INC_VAR:
+		case BC_INST_DEC_VAR:
+		case BC_INST_VAR:
+		{
+			return "v";
+		}
+
+		case BC_INST_ARRAY_ELEM:
+		case BC_INST_ARRAY:
+		{
+			return "a";
+		}
+
+		case BC_INST_NUM:
+		{
+			return "c";
+		}
+
+		case BC_INST_STR:
+		{
+			return "s";
+		}
+
+		default:
+		{
+			return inst <= BC_INST_POP ? "" : NULL;
+		}
+	}
+}
+
+// The program does not check what saved code refers to as it runs it, so that
+// is checked here, against what there will be once all of it is loaded: end
+// has the functions, variables, and arrays of the program, and the code,
+// labels, constants, and strings of the function that the code is for.
+static bool bc_bytecode_check(const char *code, size_t len, const char *labels,
+                              size_t nlabels, const BcBytecodeMark *end)
+{
+	size_t i, idx;
+
+	for (i = 0; i < nlabels; ++i) {
+		memcpy(&idx, labels + i * sizeof(size_t), sizeof(size_t));
+		if (idx > end->code) return false;
+	}
+
+	for (i = 0; i < len;) {
+
+		const char *ops = bc_bytecode_operands((uchar) code[i++]);
+
+		if (ops == NULL) return false;
+
+		for (; *ops; ++ops) {
+
+			size_t max;
+
+			if (*ops == 'r' || *ops == 'o') {
+
+				uchar op;
+
+				if (i == len) return false;
+
+				op = (uchar) code[i++];
+
+				if (*ops == 'r' ? op < BC_INST_REL_EQ || op > BC_INST_REL_GT :
+				    op < BC_INST_ASSIGN_POWER_NO_VAL ||
+				    op > BC_INST_ASSIGN_NO_VAL)
+				{
+					return false;
+				}
+
+				continue;
+			}
+
+			if (len - i < BC_VEC_INDEX_SIZE) return false;
+
+			memcpy(&idx, code + i, BC_VEC_INDEX_SIZE);
+			i += BC_VEC_INDEX_SIZE;
+
+			switch (*ops) {
+				case 'l': max = end->labels; break;
+				case 'v': max = end->vars; break;
+				case 'a': max = end->arrs; break;
+				case 'c': max = end->consts; break;
+				case 's': max = end->strs; break;
+				case 'f': max = end->fns; break;
+				default: max = SIZE_MAX; break;
+			}
+
+			// Neither main nor read() can be called.
+			if (idx >= max || (*ops == 'f' && idx <= BC_PROG_READ)) return false;
+		}
+	}
+
+	return true;
+}
+
+// Everything that reads saved code runs twice, first without load to check
+// that all of it is there, and then with it, so that a bad file can never
+// leave a program half loaded. A NULL vector means that nothing is loaded.
+// Loading happens with signals locked, so that a signal cannot leave it half
+// done either. A NULL end means that nothing is checked.
+
+static const char* bc_bytecode_loadVec(BcBytecodeReader *r, BcVec *v,
+                                       size_t size, size_t *n)
+{
+	size_t len;
+	const char *data = bc_bytecode_getBytes(r, &len, size);
+
+	if (data == NULL) return NULL;
+
+	*n = len / size;
+
+	if (v != NULL && len) {
+		BC_SIG_ASSERT_LOCKED;
+		bc_vec_npush(v, *n, data);
+	}
+
+	return data;
+}
+
+static bool bc_bytecode_loadNames(BcBytecodeReader *r, BcProgram *p,
+                                  bool var, bool load, size_t *n)
+{
+	size_t i;
+
+	if (!bc_bytecode_get(r, n, sizeof(size_t))) return false;
+
+	for (i = 0; i < *n; ++i) {
+
+		const char *name = bc_bytecode_getStr(r);
+
+		if (name == NULL) return false;
+
+		if (load) bc_program_search(p, name, var);
+		else {
+
+			const BcMap *map = var ? &p->var_map : &p->arr_map;
+
+			// A name that is already there would not get the index it had.
+			if (bc_map_index(map, name) != BC_VEC_INVALID_IDX) return false;
+		}
+	}
+
+	return true;
+}
+
+static bool bc_bytecode_loadConsts(BcBytecodeReader *r, BcVec *consts,
+                                   size_t *n)
+{
+	size_t i;
+
+	if (!bc_bytecode_get(r, n, sizeof(size_t))) return false;
+
+	for (i = 0; i < *n; ++i) {
+
+		BcConst c;
+		const char *val;
+		size_t j, len;
+
+		if (!bc_bytecode_get(r, &c.fold, sizeof(size_t))) return false;
+
+		val = bc_bytecode_getBytes(r, &len, sizeof(uchar));
+
+		if (val == NULL || !len) return false;
+		if (c.fold ? c.fold != len : memchr(val, '\0', len) != val + len - 1)
+			return false;
+
+		if (consts == NULL) continue;
+
+		BC_SIG_ASSERT_LOCKED;
+
+		c.val = bc_vm_malloc(len);
+		memcpy(c.val, val, len);
+		c.nbases = 0;
+
+		for (j = 0; j < BC_CONST_BASES; ++j) bc_num_clear(c.nums + j);
+
+		bc_vec_push(consts, &c);
+	}
+
+	return true;
+}
+
+static bool bc_bytecode_loadStrs(BcBytecodeReader *r, BcVec *strs, size_t *n) {
+
+	size_t i;
+
+	if (!bc_bytecode_get(r, n, sizeof(size_t))) return false;
+
+	for (i = 0; i < *n; ++i) {
+
+		const char *str = bc_bytecode_getStr(r);
+
+		if (str == NULL) return false;
+
+		if (strs != NULL) {
+			BC_SIG_ASSERT_LOCKED;
+			str = bc_vm_strdup(str);
+			bc_vec_push(strs, &str);
+		}
+	}
+
+	return true;
+}
+
+static bool bc_bytecode_loadBody(BcBytecodeReader *r, BcFunc *f,
+                                 const BcBytecodeMark *end)
+{
+	BcBytecodeMark fn;
+	const char *code, *labels, *autos;
+	size_t i, nautos, nparams;
+	uchar flags;
+
+	code = bc_bytecode_loadVec(r, f ? &f->code : NULL, sizeof(uchar),
+	                           &fn.code);
+	labels = bc_bytecode_loadVec(r, f ? &f->labels : NULL, sizeof(size_t),
+	                             &fn.labels);
+	autos = bc_bytecode_loadVec(r, f ? &f->autos : NULL, sizeof(BcLoc),
+	                            &nautos);
+
+	if (code == NULL || labels == NULL || autos == NULL ||
+	    !bc_bytecode_get(r, &nparams, sizeof(size_t)) ||
+	    !bc_bytecode_get(r, &flags, sizeof(uchar)))
+	{
+		return false;
+	}
+
+	if (f != NULL) {
+		f->nparams = nparams;
+		f->voidfn = (flags & 1);
+		f->pure = ((flags >> 1) & 1);
+		f->lib = ((flags >> 2) & 1);
+	}
+
+	if (!bc_bytecode_loadConsts(r, f ? &f->consts : NULL, &fn.consts) ||
+	    !bc_bytecode_loadStrs(r, f ? &f->strs : NULL, &fn.strs))
+	{
+		return false;
+	}
+
+	if (end == NULL) return true;
+
+	if (nparams > nautos) return false;
+
+	for (i = 0; i < nautos; ++i) {
+
+		BcLoc a;
+
+		memcpy(&a, autos + i * sizeof(BcLoc), sizeof(BcLoc));
+
+		if (a.idx > BC_TYPE_REF ||
+		    a.loc >= (a.idx == BC_TYPE_VAR ? end->vars : end->arrs))
+		{
+			return false;
+		}
+	}
+
+	fn.fns = end->fns;
+	fn.vars = end->vars;
+	fn.arrs = end->arrs;
+
+	return bc_bytecode_check(code, fn.code, labels, fn.labels, &fn);
+}
+
+static bool bc_bytecode_loadFunc(BcBytecodeReader *r, BcProgram *p, bool load,
+                                 bool lazy, bool redef,
+                                 const BcBytecodeMark *end)
+{
+	BcFunc *f = NULL;
+	const char *name = bc_bytecode_getStr(r);
+
+	if (name == NULL) return false;
+
+	if (load) {
+
+		size_t idx;
+
+		// This clears a function that is being defined again.
+		idx = bc_program_insertFunc(p, name);
+
+		f = bc_vec_item(&p->fns, idx);
+		assert(!f->code.len);
+
+		// The body was already checked, so it only has to be found.
+		if (lazy) {
+			f->saved = r->buf + r->i;
+			bc_bytecode_loadBody(r, NULL, NULL);
+			f->saved_len = (size_t) (r->buf + r->i - f->saved);
+			return true;
+		}
+	}
+	else {
+
+		size_t idx = bc_map_index(&p->fn_map, name);
+
+		// Only a function that is already there can be defined again, and
+		// main and read() cannot be.
+		if (idx == BC_VEC_INVALID_IDX ? redef :
+		    !redef || bc_map_item(&p->fn_map, idx)->idx <= BC_PROG_READ)
+		{
+			return false;
+		}
+	}
+
+	return bc_bytecode_loadBody(r, f, end);
+}
+
+static bool bc_bytecode_loadAll(BcBytecodeReader *r, BcProgram *p, bool load,
+                                bool lazy)
+{
+	BcFunc *f;
+	BcBytecodeMark end, *check = load ? NULL : &end;
+	const char *code, *labels;
+	size_t i, n, len, nlabels, nconsts, nstrs;
+
+	bc_bytecode_mark(p, &end);
+
+	if (!bc_bytecode_loadNames(r, p, true, load, &n)) return false;
+	end.vars += n;
+
+	if (!bc_bytecode_loadNames(r, p, false, load, &n)) return false;
+	end.arrs += n;
+
+	if (!bc_bytecode_get(r, &n, sizeof(size_t))) return false;
+	end.fns += n;
+
+	for (i = 0; i < n; ++i) {
+		if (!bc_bytecode_loadFunc(r, p, load, lazy, false, check)) return false;
+	}
+
+	if (!bc_bytecode_get(r, &n, sizeof(size_t))) return false;
+
+	for (i = 0; i < n; ++i) {
+		if (!bc_bytecode_loadFunc(r, p, load, lazy, true, check)) return false;
+	}
+
+	f = load ? bc_vec_item(&p->fns, BC_PROG_MAIN) : NULL;
+
+	code = bc_bytecode_loadVec(r, f ? &f->code : NULL, sizeof(uchar), &len);
+	labels = bc_bytecode_loadVec(r, f ? &f->labels : NULL, sizeof(size_t),
+	                             &nlabels);
+
+	if (code == NULL || labels == NULL ||
+	    !bc_bytecode_loadConsts(r, f ? &f->consts : NULL, &nconsts) ||
+	    !bc_bytecode_loadStrs(r, f ? &f->strs : NULL, &nstrs))
+	{
+		return false;
+	}
+
+	if (check == NULL) return true;
+
+	// Code outside of functions is added to main, and it can refer to what
+	// main already had.
+	end.code += len;
+	end.labels += nlabels;
+	end.consts += nconsts;
+	end.strs += nstrs;
+
+	return bc_bytecode_check(code, len, labels, nlabels, &end);
+}
+
+bool bc_bytecode_load(BcProgram *p, const char *buf, size_t len, bool lazy) {
+
+	BcBytecodeReader r;
+	BcBytecodeMark m, now;
+	const char *version;
+	uchar build[BC_BYTECODE_BUILD_LEN], now_build[BC_BYTECODE_BUILD_LEN];
+	size_t start;
+	sig_atomic_t lock;
+
+	assert(p != NULL && buf != NULL);
+
+	if (len < BC_BYTECODE_MAGIC_LEN ||
+	    memcmp(buf, BC_BYTECODE_MAGIC, BC_BYTECODE_MAGIC_LEN))
+	{
+		return false;
+	}
+
+	r.buf = buf;
+	r.len = len;
+	r.i = BC_BYTECODE_MAGIC_LEN;
+
+	bc_bytecode_build(now_build);
+
+	if (!bc_bytecode_get(&r, build, BC_BYTECODE_BUILD_LEN) ||
+	    memcmp(build, now_build, BC_BYTECODE_BUILD_LEN))
+	{
+		return false;
+	}
+
+	version = bc_bytecode_getStr(&r);
+
+	if (version == NULL || strcmp(version, BC_VERSION)) return false;
+
+	bc_bytecode_mark(p, &now);
+
+	if (!bc_bytecode_get(&r, &m, sizeof(BcBytecodeMark)) ||
+	    memcmp(&m, &now, sizeof(BcBytecodeMark)))
+	{
+		return false;
+	}
+
+	start = r.i;
+
+	if (!bc_bytecode_loadAll(&r, p, false, false) || r.i != len) return false;
+
+	r.i = start;
+
+	BC_SIG_TRYLOCK(lock);
+
+	bc_bytecode_loadAll(&r, p, true, lazy);
+
+	BC_SIG_TRYUNLOCK(lock);
+
+	return true;
+}
+
+void bc_bytecode_loadSaved(BcFunc *f) {
+
+	BcBytecodeReader r;
+	bool good;
+
+	assert(f->saved != NULL && !f->code.len);
+
+	r.buf = f->saved;
+	r.len = f->saved_len;
+	r.i = 0;
+
+	BC_SIG_LOCK;
+
+	good = bc_bytecode_loadBody(&r, f, NULL);
+
+	assert(good && r.i == r.len);
+	BC_UNUSED(good);
+
+	f->saved = NULL;
+
+	BC_SIG_UNLOCK;
+}
+
+static void bc_bytecode_digestNames(uint64_t h[2], const BcMap *map) {
+
+	size_t i;
+
+	for (i = 0; i < map->ids.len; ++i) {
+		const char *name = bc_map_item(map, i)->name;
+		bc_bytecode_digest(h, name, strlen(name) + 1);
+	}
+}
+
+void bc_bytecode_key(const BcProgram *p, const char *text, size_t len,
+                     BcBytecodeKey *key)
+{
+	uchar build[BC_BYTECODE_BUILD_LEN];
+	BcBytecodeMark m;
+
+	// Parsing only depends on the text and on what names the program has. The
+	// build is in the digest too, so that different builds that share a
+	// directory use different files.
+	bc_bytecode_build(build);
+	bc_bytecode_mark(p, &m);
+
+	key->len = len;
+
+	bc_bytecode_digestInit(key->digest);
+	bc_bytecode_digest(key->digest, BC_VERSION, sizeof(BC_VERSION));
+	bc_bytecode_digest(key->digest, build, BC_BYTECODE_BUILD_LEN);
+	bc_bytecode_digest(key->digest, &m, sizeof(BcBytecodeMark));
+	bc_bytecode_digestNames(key->digest, &p->fn_map);
+	bc_bytecode_digestNames(key->digest, &p->var_map);
+	bc_bytecode_digestNames(key->digest, &p->arr_map);
+	bc_bytecode_digest(key->digest, text, len);
+}
+
+void bc_bytecode_fileInit(BcBytecodeFile *f, const BcProgram *p) {
+
+	BC_SIG_ASSERT_LOCKED;
+
+	bc_vec_init(&f->buf, sizeof(uchar), NULL);
+	bc_vec_init(&f->redefs, sizeof(size_t), NULL);
+
+	bc_vec_expand(&f->buf, BC_BYTECODE_FILE_HEADER);
+	f->buf.len = BC_BYTECODE_FILE_HEADER;
+
+	bc_bytecode_mark(p, &f->mark);
+	f->quit = false;
+}
+
+void bc_bytecode_fileFree(BcBytecodeFile *f) {
+	BC_SIG_ASSERT_LOCKED;
+	bc_vec_free(&f->buf);
+	bc_vec_free(&f->redefs);
+}
+
+void bc_bytecode_fileRedef(BcBytecodeFile *f, size_t idx) {
+
+	size_t i;
+
+	// New functions are all saved anyway.
+	if (idx >= f->mark.fns) return;
+
+	for (i = 0; i < f->redefs.len; ++i) {
+		if (*((size_t*) bc_vec_item(&f->redefs, i)) == idx) return;
+	}
+
+	bc_vec_push(&f->redefs, &idx);
+}
+
+void bc_bytecode_filePart(BcBytecodeFile *f, const BcProgram *p) {
+
+	size_t start = f->buf.len, len;
+
+	bc_bytecode_size(&f->buf, 0);
+	bc_bytecode_save(p, &f->mark, &f->redefs, &f->buf);
+
+	len = f->buf.len - start - sizeof(size_t);
+	memcpy(f->buf.v + start, &len, sizeof(size_t));
+
+	bc_bytecode_mark(p, &f->mark);
+	bc_vec_npop(&f->redefs, f->redefs.len);
+}
+
+void bc_bytecode_fileEnd(BcBytecodeFile *f, const BcBytecodeKey *key) {
+
+	char *buf = f->buf.v;
+	uint64_t sum[2];
+
+	bc_bytecode_digestInit(sum);
+	bc_bytecode_digest(sum, buf + BC_BYTECODE_FILE_HEADER,
+	                   f->buf.len - BC_BYTECODE_FILE_HEADER);
+
+	memcpy(buf, BC_BYTECODE_FILE_MAGIC, BC_BYTECODE_FILE_MAGIC_LEN);
+	buf += BC_BYTECODE_FILE_MAGIC_LEN;
+
+	bc_bytecode_build((uchar*) buf);
+	buf += BC_BYTECODE_BUILD_LEN;
+
+	memcpy(buf, &key->len, sizeof(size_t));
+	buf += sizeof(size_t);
+	memcpy(buf, key->digest, sizeof(key->digest));
+	buf += sizeof(key->digest);
+	memcpy(buf, sum, sizeof(sum));
+	buf += sizeof(sum);
+
+	*buf = (char) f->quit;
+}
+
+bool bc_bytecode_fileOpen(BcBytecodeReader *r, const BcBytecodeKey *key,
+                          bool *quit)
+{
+	uchar build[BC_BYTECODE_BUILD_LEN];
+	uint64_t digest[2], sum[2];
+	size_t len;
+	const char *buf = r->buf + BC_BYTECODE_FILE_MAGIC_LEN;
+
+	if (r->len < BC_BYTECODE_FILE_HEADER ||
+	    memcmp(r->buf, BC_BYTECODE_FILE_MAGIC, BC_BYTECODE_FILE_MAGIC_LEN))
+	{
+		return false;
+	}
+
+	// A file from another kind of build would only fail once it is running.
+	bc_bytecode_build(build);
+	if (memcmp(buf, build, BC_BYTECODE_BUILD_LEN)) return false;
+	buf += BC_BYTECODE_BUILD_LEN;
+
+	memcpy(&len, buf, sizeof(size_t));
+	buf += sizeof(size_t);
+	memcpy(digest, buf, sizeof(digest));
+	buf += sizeof(digest);
+	memcpy(sum, buf, sizeof(sum));
+	buf += sizeof(sum);
+
+	*quit = (*buf != 0);
+
+	if (len != key->len || memcmp(digest, key->digest, sizeof(digest)))
+		return false;
+
+	r->i = BC_BYTECODE_FILE_HEADER;
+
+	// Parts after the first can only be checked as they are loaded, when it
+	// is too late to parse the file instead, so the whole file is checked now.
+	bc_bytecode_digestInit(digest);
+	bc_bytecode_digest(digest, r->buf + r->i, r->len - r->i);
+	if (memcmp(digest, sum, sizeof(sum))) return false;
+
+	while (r->i < r->len) {
+
+		size_t part;
+
+		if (!bc_bytecode_getBytes(r, &part, sizeof(uchar))) return false;
+	}
+
+	r->i = BC_BYTECODE_FILE_HEADER;
+
+	return true;
+}
+
+bool bc_bytecode_fileNext(BcBytecodeReader *r, BcProgram *p) {
+
+	size_t len;
+	const char *buf;
+
+	if (r->i == r->len) return false;
+
+	buf = bc_bytecode_getBytes(r, &len, sizeof(uchar));
+	assert(buf != NULL);
+
+	if (BC_ERR(!bc_bytecode_load(p, buf, len, false)))
+		bc_vm_err(BC_ERR_FATAL_IO_ERR);
+
+	return true;
+}
+
+#endif // BC_ENABLED
@@ -517,7 +517,7 @@ char *bc_history_debug_buf;
 const char bc_func_main[] = "(main)";
 const char bc_func_read[] = "(read)";
 
-#if BC_DEBUG_CODE
+#if BC_DEBUG_CODE || !BC_ENABLE_LIBRARY
 const char* bc_inst_names[] = {
 
 #if BC_ENABLED
@@ -599,26 +599,26 @@ const char* bc_inst_names[] = {
 	"BC_INST_IBASE",
 	"BC_INST_OBASE",
 	"BC_INST_SCALE",
-#if BC_ENABLE_EXTRA_MATH
+#if BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
 	"BC_INST_SEED",
-#endif // BC_ENABLE_EXTRA_MATH
+#endif // BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
 	"BC_INST_LENGTH",
 	"BC_INST_SCALE_FUNC",
 	"BC_INST_SQRT",
 	"BC_INST_ABS",
-#if BC_ENABLE_EXTRA_MATH
+#if BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
 	"BC_INST_IRAND",
-#endif // BC_ENABLE_EXTRA_MATH
+#endif // BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
 	"BC_INST_READ",
-#if BC_ENABLE_EXTRA_MATH
+#if BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
 	"BC_INST_RAND",
-#endif // BC_ENABLE_EXTRA_MATH
+#endif // BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
 	"BC_INST_MAXIBASE",
 	"BC_INST_MAXOBASE",
 	"BC_INST_MAXSCALE",
-#if BC_ENABLE_EXTRA_MATH
+#if BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
 	"BC_INST_MAXRAND",
-#endif // BC_ENABLE_EXTRA_MATH
+#endif // BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
 
 	"BC_INST_PRINT",
 	"BC_INST_PRINT_POP",
@@ -630,16 +630,24 @@ const char* bc_inst_names[] = {
 	"BC_INST_JUMP_ZERO",
 
 	"BC_INST_CALL",
+	"BC_INST_CALL_CONST",
+	"BC_INST_CALL_TAIL",
 
 	"BC_INST_RET",
 	"BC_INST_RET0",
 	"BC_INST_RET_VOID",
 
 	"BC_INST_HALT",
+
+	"BC_INST_INC_VAR",
+	"BC_INST_DEC_VAR",
+	"BC_INST_ASSIGN_VAR",
+	"BC_INST_JUMP_VAR_NUM",
 #endif // BC_ENABLED
 
-#if DC_ENABLED
 	"BC_INST_POP",
+
+#if DC_ENABLED
 	"BC_INST_POP_EXEC",
 	"BC_INST_MODEXP",
 	"BC_INST_DIVMOD",
@@ -664,7 +672,7 @@ const char* bc_inst_names[] = {
 	"BC_INST_NQUIT",
 #endif // DC_ENABLED
 };
-#endif // BC_DEBUG_CODE
+#endif // BC_DEBUG_CODE || !BC_ENABLE_LIBRARY
 
 const char bc_parse_zero[2] = "0";
 const char bc_parse_one[2] = "1";
@@ -54,15 +54,20 @@ static void dc_lex_register(BcLex *l) {
 		bc_lex_whitespace(l);
 		c = l->buf[l->i];
 
-		if (!isalnum(c) && c != '_')
-			bc_lex_verr(l, BC_ERR_PARSE_CHAR, c);
+		if (!isalnum(c) && c != '_') bc_lex_invalidChar(l, c);
 
 		l->i += 1;
 		bc_lex_name(l);
 	}
 	else {
+
+		char c = l->buf[l->i - 1];
+
+		// The NUL at the end of the text is not a binary byte.
+		if (BC_ERR(c && BC_LEX_BIN(l, c))) bc_lex_binary(l);
+
 		bc_vec_npop(&l->str, l->str.len);
-		bc_vec_pushByte(&l->str, (uchar) l->buf[l->i - 1]);
+		bc_vec_pushByte(&l->str, (uchar) c);
 		bc_vec_pushByte(&l->str, '\0');
 		l->t = BC_LEX_NAME;
 	}
@@ -87,6 +92,8 @@ static void dc_lex_string(BcLex *l) {
 			depth -= (c == ']');
 		}
 
+		if (BC_ERR(BC_LEX_BIN(l, c))) bc_lex_binary(l);
+
 		nls += (c == '\n');
 
 		if (depth) bc_vec_push(&l->str, &c);
@@ -82,12 +82,40 @@ static BcStatus bc_file_output(int fd, const char *buf, size_t n) {
 	return BC_STATUS_SUCCESS;
 }
 
+static BcStatus bc_file_send(BcFile *restrict f, const char *buf, size_t n) {
+
+#if BC_VM_SERVER
+	if (vm.server != NULL && vm.server->batch) {
+
+		BcStatus s;
+		sig_atomic_t lock;
+		size_t rec[2];
+
+		rec[0] = f == &vm.ferr ? BC_VM_BATCH_ERR : BC_VM_BATCH_OUT;
+		rec[1] = n;
+
+		// The record has to go out whole, or the first process cannot read
+		// the rest of them.
+		BC_SIG_TRYLOCK(lock);
+
+		s = bc_file_output(f->fd, (const char*) rec, sizeof(rec));
+		if (s == BC_STATUS_SUCCESS) s = bc_file_output(f->fd, buf, n);
+
+		BC_SIG_TRYUNLOCK(lock);
+
+		return s;
+	}
+#endif // BC_VM_SERVER
+
+	return bc_file_output(f->fd, buf, n);
+}
+
 BcStatus bc_file_flushErr(BcFile *restrict f) {
 
 	BcStatus s;
 
 	if (f->len) {
-		s = bc_file_output(f->fd, f->buf, f->len);
+		s = bc_file_send(f, f->buf, f->len);
 		f->len = 0;
 	}
 	else s = BC_STATUS_SUCCESS;
@@ -116,7 +144,7 @@ void bc_file_write(BcFile *restrict f, const char *buf, size_t n) {
 		assert(!f->len);
 	}
 
-	if (BC_UNLIKELY(n > f->cap - f->len)) bc_file_output(f->fd, buf, n);
+	if (BC_UNLIKELY(n > f->cap - f->len)) bc_file_send(f, buf, n);
 	else {
 		memcpy(f->buf + f->len, buf, n);
 		f->len += n;
@@ -141,6 +169,7 @@ void bc_file_vprintf(BcFile *restrict f, const char *fmt, va_list args) {
 	while ((percent = strchr(ptr, '%')) != NULL) {
 
 		char c;
+		bool ll = false;
 
 		if (percent != ptr) {
 			size_t len = (size_t) (percent - ptr);
@@ -182,9 +211,12 @@ void bc_file_vprintf(BcFile *restrict f, const char *fmt, va_list args) {
 
 			unsigned long long ull;
 
-			assert((c == 'l' || c == 'z') && percent[2] == 'u');
+			ll = (c == 'l' && percent[2] == 'l');
+
+			assert((c == 'l' || c == 'z') && percent[2 + ll] == 'u');
 
 			if (c == 'z') ull = (unsigned long long) va_arg(args, size_t);
+			else if (ll) ull = va_arg(args, unsigned long long);
 			else ull = (unsigned long long) va_arg(args, unsigned long);
 
 			if (!ull) bc_file_putchar(f, '0');
@@ -194,7 +226,7 @@ void bc_file_vprintf(BcFile *restrict f, const char *fmt, va_list args) {
 			}
 		}
 
-		ptr = percent + 2 + (c == 'l' || c == 'z');
+		ptr = percent + 2 + (c == 'l' || c == 'z') + ll;
 	}
 
 	if (ptr[0]) bc_file_puts(f, ptr);
@@ -34,6 +34,7 @@
  */
 
 #include <assert.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -56,10 +57,11 @@ void bc_string_free(void *string) {
 
 void bc_const_free(void *constant) {
 	BcConst *c = constant;
+	size_t i;
 	BC_SIG_ASSERT_LOCKED;
 	assert(c->val != NULL);
 	free(c->val);
-	bc_num_free(&c->num);
+	for (i = 0; i < BC_CONST_BASES; ++i) bc_num_free(c->nums + i);
 }
 
 #if BC_ENABLED
@@ -96,18 +98,24 @@ void bc_func_init(BcFunc *f, const char *name) {
 
 	bc_vec_init(&f->code, sizeof(uchar), NULL);
 
-	bc_vec_init(&f->consts, sizeof(BcConst), bc_const_free);
+	// Library functions are added long before they are loaded, if they ever
+	// are, and many functions have no constants or strings.
+	bc_vec_initLazy(&f->consts, sizeof(BcConst), bc_const_free);
 
 #if BC_ENABLED
 	if (BC_IS_BC) {
 
-		bc_vec_init(&f->strs, sizeof(char*), bc_string_free);
+		bc_vec_initLazy(&f->strs, sizeof(char*), bc_string_free);
 
-		bc_vec_init(&f->autos, sizeof(BcLoc), NULL);
-		bc_vec_init(&f->labels, sizeof(size_t), NULL);
+		bc_vec_initLazy(&f->autos, sizeof(BcLoc), NULL);
+		bc_vec_initLazy(&f->labels, sizeof(size_t), NULL);
 
 		f->nparams = 0;
+		f->saved = NULL;
+		f->saved_len = 0;
 		f->voidfn = false;
+		f->pure = false;
+		f->lib = false;
 	}
 #endif // BC_ENABLED
 
@@ -132,7 +140,11 @@ void bc_func_reset(BcFunc *f) {
 		bc_vec_npop(&f->labels, f->labels.len);
 
 		f->nparams = 0;
+		f->saved = NULL;
+		f->saved_len = 0;
 		f->voidfn = false;
+		f->pure = false;
+		f->lib = false;
 	}
 #endif // BC_ENABLED
 }
@@ -174,14 +186,210 @@ void bc_array_init(BcVec *a, bool nums) {
 	bc_array_expand(a, 1);
 }
 
+static size_t bc_array_hash(size_t idx) {
+#if SIZE_MAX > UINT32_MAX
+	idx *= (size_t) UINTMAX_C(0x9E3779B97F4A7C15);
+#else // SIZE_MAX > UINT32_MAX
+	idx *= (size_t) UINT32_C(0x9E3779B9);
+#endif // SIZE_MAX > UINT32_MAX
+	return idx ^ (idx >> (sizeof(size_t) * CHAR_BIT / 2));
+}
+
+static BcArrElem* bc_array_slot(const BcSparse *s, size_t idx) {
+
+	size_t i, mask = s->cap - 1;
+
+	for (i = bc_array_hash(idx) & mask; s->elems[i].idx != idx &&
+	     s->elems[i].idx != BC_ARRAY_SPARSE_NONE; i = (i + 1) & mask);
+
+	return s->elems + i;
+}
+
+static void bc_array_sparseAlloc(BcSparse *s, size_t cap) {
+
+	size_t i;
+
+	assert(cap && !(cap & (cap - 1)));
+
+	s->cap = cap;
+	s->elems = bc_vm_malloc(bc_vm_arraySize(cap, sizeof(BcArrElem)));
+
+	for (i = 0; i < cap; ++i) s->elems[i].idx = BC_ARRAY_SPARSE_NONE;
+}
+
+static BcArrElem* bc_array_sparseAdd(BcSparse *s, size_t idx) {
+
+	BcArrElem *e;
+
+	if (BC_VEC_HASH_FULL(s->used, s->cap)) {
+
+		BcArrElem *old = s->elems;
+		size_t i, cap = s->cap;
+
+		bc_array_sparseAlloc(s, bc_vm_growSize(cap, cap));
+
+		for (i = 0; i < cap; ++i) {
+			if (old[i].idx == BC_ARRAY_SPARSE_NONE) continue;
+			memcpy(bc_array_slot(s, old[i].idx), old + i, sizeof(BcArrElem));
+		}
+
+		free(old);
+	}
+
+	e = bc_array_slot(s, idx);
+
+	assert(e->idx == BC_ARRAY_SPARSE_NONE);
+
+	e->idx = idx;
+	s->used += 1;
+	if (idx >= s->len) s->len = idx + 1;
+
+	return e;
+}
+
+static void bc_array_sparseFree(void *sparse) {
+
+	BcSparse *s = (BcSparse*) sparse;
+	size_t i;
+
+	BC_SIG_ASSERT_LOCKED;
+
+	for (i = 0; i < s->cap; ++i) {
+		if (s->elems[i].idx != BC_ARRAY_SPARSE_NONE)
+			bc_num_free(&s->elems[i].n);
+	}
+
+	free(s->elems);
+}
+
+static void bc_array_sparseCopy(BcVec *d, const BcSparse *src) {
+
+	BcSparse s;
+	size_t i;
+
+	s.len = src->len;
+	s.used = src->used;
+
+	// The same capacity puts every element in the same slot.
+	bc_array_sparseAlloc(&s, src->cap);
+
+	for (i = 0; i < src->cap; ++i) {
+		if (src->elems[i].idx == BC_ARRAY_SPARSE_NONE) continue;
+		s.elems[i].idx = src->elems[i].idx;
+		bc_num_createCopy(&s.elems[i].n, &src->elems[i].n);
+	}
+
+	bc_vec_init(d, sizeof(BcSparse), bc_array_sparseFree);
+	bc_vec_push(d, &s);
+}
+
+static void bc_array_sparsify(BcVec *a) {
+
+	BcSparse s;
+	size_t i, cap = 16;
+
+	assert(!BC_ARRAY_SPARSE(a));
+
+	while (BC_VEC_HASH_FULL(a->len, cap)) cap *= 2;
+
+	s.len = a->len;
+	s.used = 0;
+
+	bc_array_sparseAlloc(&s, cap);
+
+	// Zeroes are what missing elements read as, so they are dropped.
+	for (i = 0; i < a->len; ++i) {
+		BcNum *n = bc_vec_item(a, i);
+		if (BC_NUM_ZERO(n)) bc_num_free(n);
+		else memcpy(&bc_array_sparseAdd(&s, i)->n, n, sizeof(BcNum));
+	}
+
+	a->len = 0;
+	bc_vec_free(a);
+
+	bc_vec_init(a, sizeof(BcSparse), bc_array_sparseFree);
+	bc_vec_push(a, &s);
+}
+
+static bool bc_array_sparse(const BcVec *a, size_t idx) {
+
+	size_t i, used, len, gap = idx - a->len;
+
+	// Indices are at most BC_MAX_DIM, so this cannot overflow, even though
+	// the length is too big to allocate.
+	assert(idx <= BC_MAX_DIM);
+	len = idx + 1;
+
+	if (len < BC_ARRAY_SPARSE_GAP) return false;
+	if (gap >= BC_ARRAY_SPARSE_GAP && gap > a->len) return true;
+
+	// Smaller steps can still leave most of the array unused, so the array is
+	// checked each time its length passes a power of two. Zeroes cannot be
+	// told apart from unused elements, so only a step that leaves too many
+	// unused elements by itself counts; an array filled in order, even with
+	// zeroes, stays dense.
+	if (gap < BC_ARRAY_SPARSE_DENSITY || (a->len ^ len) <= a->len) return false;
+
+	for (i = used = 0; i < a->len; ++i)
+		used += BC_NUM_NONZERO((BcNum*) bc_vec_item(a, i));
+
+	return used < len / BC_ARRAY_SPARSE_DENSITY;
+}
+
+BcNum* bc_array_find(const BcVec *a, size_t idx) {
+
+	BcArrElem *e;
+
+	if (!BC_ARRAY_SPARSE(a)) return idx < a->len ? bc_vec_item(a, idx) : NULL;
+
+	e = bc_array_slot(bc_vec_item(a, 0), idx);
+
+	return e->idx == idx ? &e->n : NULL;
+}
+
+BcNum* bc_array_item(BcVec *a, size_t idx) {
+
+	BcNum *n = bc_array_find(a, idx), temp;
+
+	BC_SIG_ASSERT_LOCKED;
+
+	if (n != NULL) return n;
+
+	if (!BC_ARRAY_SPARSE(a) && !bc_array_sparse(a, idx)) {
+		bc_array_expand(a, bc_vm_growSize(idx, 1));
+		return bc_vec_item(a, idx);
+	}
+
+	if (!BC_ARRAY_SPARSE(a)) bc_array_sparsify(a);
+
+	bc_num_init(&temp, BC_NUM_DEF_SIZE);
+
+	n = &bc_array_sparseAdd(bc_vec_item(a, 0), idx)->n;
+	memcpy(n, &temp, sizeof(BcNum));
+
+	return n;
+}
+
+size_t bc_array_len(const BcVec *a) {
+	if (!BC_ARRAY_SPARSE(a)) return a->len;
+	return ((BcSparse*) bc_vec_item(a, 0))->len;
+}
+
 void bc_array_copy(BcVec *d, const BcVec *s) {
 
 	size_t i;
 
 	BC_SIG_ASSERT_LOCKED;
 
-	assert(d != NULL && s != NULL);
-	assert(d != s && d->size == s->size && d->dtor == s->dtor);
+	assert(d != NULL && s != NULL && d != s);
+
+	if (BC_ARRAY_SPARSE(s)) {
+		bc_vec_free(d);
+		bc_array_sparseCopy(d, bc_vec_item(s, 0));
+		return;
+	}
+
+	assert(d->size == s->size && d->dtor == s->dtor);
 
 	bc_vec_npop(d, d->len);
 	bc_vec_expand(d, s->cap);
@@ -257,6 +465,7 @@ void bc_result_copy(BcResult *d, BcResult *src) {
 		}
 
 		case BC_RESULT_STR:
+		case BC_RESULT_CONST:
 		{
 			memcpy(&d->d.n, &src->d.n, sizeof(BcNum));
 			break;
@@ -310,6 +519,7 @@ void bc_result_free(void *result) {
 #endif // BC_ENABLED
 		case BC_RESULT_ARRAY_ELEM:
 		case BC_RESULT_STR:
+		case BC_RESULT_CONST:
 		case BC_RESULT_ZERO:
 		case BC_RESULT_ONE:
 #if BC_ENABLED
@@ -44,12 +44,25 @@
 
 void bc_lex_invalidChar(BcLex *l, char c) {
 	l->t = BC_LEX_INVALID;
+	if (BC_ERR(c && BC_LEX_BIN(l, c))) bc_lex_binary(l);
 	bc_lex_verr(l, BC_ERR_PARSE_CHAR, c);
 }
 
+void bc_lex_binary(BcLex *l) {
+	l->t = BC_LEX_INVALID;
+	bc_vm_verr(BC_ERR_FATAL_BIN_FILE, vm.file);
+}
+
 void bc_lex_lineComment(BcLex *l) {
+
+	char c;
+
 	l->t = BC_LEX_WHITESPACE;
-	while (l->i < l->len && l->buf[l->i] != '\n') l->i += 1;
+
+	while (l->i < l->len && (c = l->buf[l->i]) != '\n') {
+		if (BC_ERR(BC_LEX_BIN(l, c))) bc_lex_binary(l);
+		l->i += 1;
+	}
 }
 
 void bc_lex_comment(BcLex *l) {
@@ -64,7 +77,10 @@ void bc_lex_comment(BcLex *l) {
 
 	for (i = l->i; !end; i += !end) {
 
-		for (; (c = buf[i]) && c != '*'; ++i) nlines += (c == '\n');
+		for (; (c = buf[i]) && c != '*'; ++i) {
+			if (BC_ERR(BC_LEX_BIN(l, c))) bc_lex_binary(l);
+			nlines += (c == '\n');
+		}
 
 		if (BC_ERR(!c || buf[i + 1] == '\0')) {
 			l->i = i;
@@ -156,7 +172,7 @@ void bc_lex_number(BcLex *l, char start) {
 			}
 
 			if (BC_ERR(!BC_LEX_NUM_CHAR(c, false, true)))
-				bc_lex_verr(l, BC_ERR_PARSE_CHAR, c);
+				bc_lex_invalidChar(l, c);
 
 			l->i += bc_lex_num(l, 0, true);
 		}
@@ -186,6 +202,7 @@ void bc_lex_init(BcLex *l) {
 	BC_SIG_ASSERT_LOCKED;
 	assert(l != NULL);
 	bc_vec_init(&l->str, sizeof(char), NULL);
+	l->bin = false;
 }
 
 void bc_lex_free(BcLex *l) {
@@ -197,6 +214,7 @@ void bc_lex_free(BcLex *l) {
 void bc_lex_file(BcLex *l, const char *file) {
 	assert(l != NULL && file != NULL);
 	l->line = 1;
+	l->bin = false;
 	vm.file = file;
 }
 
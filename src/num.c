@@ -55,6 +55,16 @@ ssize_t bc_num_cmpZero(const BcNum *n) {
 	return bc_num_neg((n)->len != 0, BC_NUM_NEG(n));
 }
 
+// A small number is an integer with no scale that fits in one limb. The fast
+// paths for them do the math on machine integers, without the limb loops.
+static inline bool bc_num_isSmall(const BcNum *n) {
+	return n->len <= 1 && !BC_NUM_RDX_VAL(n) && !n->scale;
+}
+
+static inline BcBigDig bc_num_smallVal(const BcNum *n) {
+	return n->len ? (BcBigDig) n->num[0] : 0;
+}
+
 static inline size_t bc_num_int(const BcNum *n) {
 	return n->len ? n->len - BC_NUM_RDX_VAL(n) : 0;
 }
@@ -264,6 +274,12 @@ ssize_t bc_num_cmp(const BcNum *a, const BcNum *b) {
 	}
 	else if (BC_NUM_NEG(b)) return 1;
 
+	// Small integers only have one limb to compare.
+	if (bc_num_isSmall(a) && bc_num_isSmall(b)) {
+		if (a->num[0] == b->num[0]) return 0;
+		return bc_num_neg(1, (a->num[0] < b->num[0]) != neg);
+	}
+
 	a_int = bc_num_int(a);
 	b_int = bc_num_int(b);
 	a_int -= b_int;
@@ -566,7 +582,53 @@ static void bc_num_intop(const BcNum *a, const BcNum *b, BcNum *restrict c,
 }
 #endif // BC_ENABLE_EXTRA_MATH
 
-static void bc_num_as(BcNum *a, BcNum *b, BcNum *restrict c, size_t sub) {
+static void bc_num_setSmall(BcNum *restrict c, BcBigDig val, bool neg) {
+
+	// Products of two limbs are less than two limbs.
+	assert(val < ((BcBigDig) BC_BASE_POW) * BC_BASE_POW);
+
+	bc_num_expand(c, 2);
+
+	c->num[0] = (BcDig) (val % BC_BASE_POW);
+	c->num[1] = (BcDig) (val / BC_BASE_POW);
+	c->len = c->num[1] ? 2 : (c->num[0] != 0);
+	c->scale = 0;
+
+	BC_NUM_RDX_SET_NEG(c, 0, neg && c->len);
+}
+
+static bool bc_num_asSmall(BcNum *a, BcNum *b, BcNum *c, bool sub) {
+
+	BcBigDig x, y;
+	bool aneg, bneg;
+
+	if (!bc_num_isSmall(a) || !bc_num_isSmall(b)) return false;
+
+	x = bc_num_smallVal(a);
+	y = bc_num_smallVal(b);
+	aneg = BC_NUM_NEG(a);
+	bneg = (BC_NUM_NEG(b) != sub);
+
+	if (aneg == bneg) bc_num_setSmall(c, x + y, aneg);
+	else if (x >= y) bc_num_setSmall(c, x - y, aneg);
+	else bc_num_setSmall(c, y - x, bneg);
+
+	return true;
+}
+
+static bool bc_num_mSmall(BcNum *a, BcNum *b, BcNum *c) {
+
+	bool neg;
+
+	if (!bc_num_isSmall(a) || !bc_num_isSmall(b)) return false;
+
+	neg = (BC_NUM_NEG(a) != BC_NUM_NEG(b));
+	bc_num_setSmall(c, bc_num_smallVal(a) * bc_num_smallVal(b), neg);
+
+	return true;
+}
+
+static void bc_num_as(BcNum *a, BcNum *b, BcNum *c, size_t sub) {
 
 	BcDig *ptr_c, *ptr_l, *ptr_r;
 	size_t i, min_rdx, max_rdx, diff, a_int, b_int, min_len, max_len, max_int;
@@ -587,6 +649,22 @@ static void bc_num_as(BcNum *a, BcNum *b, BcNum *restrict c, size_t sub) {
 		return;
 	}
 
+	// If c is a, the limbs of a are overwritten right after they are read,
+	// which only works if they do not move. Padding a with zero limbs until it
+	// has as many fractional limbs as b makes sure of that.
+	if (c == a && BC_NUM_RDX_VAL(a) < BC_NUM_RDX_VAL(b)) {
+
+		diff = BC_NUM_RDX_VAL(b) - BC_NUM_RDX_VAL(a);
+
+		assert(a->len + diff <= a->cap);
+
+		memmove(a->num + diff, a->num, BC_NUM_SIZE(a->len));
+		memset(a->num, 0, BC_NUM_SIZE(diff));
+
+		a->len += diff;
+		BC_NUM_RDX_SET(a, BC_NUM_RDX_VAL(b));
+	}
+
 	// Invert sign of b if it is to be subtracted. This operation must
 	// preced the tests for any of the operands being zero.
 	b_neg = (BC_NUM_NEG(b) != sub);
@@ -651,7 +729,7 @@ static void bc_num_as(BcNum *a, BcNum *b, BcNum *restrict c, size_t sub) {
 			// !do_rev_sub && ardx > brdx || do_rev_sub && brdx > ardx
 			// The left operand has BcDig values that need to be copied,
 			// either from a or from b (in case of a reversed subtraction).
-			memcpy(ptr_c, ptr_l, BC_NUM_SIZE(diff));
+			if (ptr_c != ptr_l) memcpy(ptr_c, ptr_l, BC_NUM_SIZE(diff));
 			ptr_l += diff;
 			len_l -= diff;
 		}
@@ -669,7 +747,7 @@ static void bc_num_as(BcNum *a, BcNum *b, BcNum *restrict c, size_t sub) {
 			else {
 
 				// !do_sub && brdx > ardx
-				memcpy(ptr_c, ptr_r, BC_NUM_SIZE(diff));
+				if (ptr_c != ptr_r) memcpy(ptr_c, ptr_r, BC_NUM_SIZE(diff));
 			}
 
 			ptr_r += diff;
@@ -2606,21 +2684,43 @@ size_t bc_num_placesReq(const BcNum *a, const BcNum *b, size_t scale) {
 }
 #endif // BC_ENABLE_EXTRA_MATH
 
+// Addition and subtraction can write their result over a as they go, so
+// something like "s += x" does not need new limbs for s unless it grows past
+// its capacity. There is nothing to free then, so this is kept out of
+// bc_num_binary() and its setjmp.
+static bool bc_num_asInPlace(BcNum *a, BcNum *b, BcNum *c, bool sub,
+                             size_t scale)
+{
+	if (c != a || c == b) return false;
+
+	bc_num_expand(c, bc_num_addReq(a, b, scale));
+	bc_num_as(a, b, c, sub);
+
+	assert(BC_NUM_RDX_VALID(c));
+
+	return true;
+}
+
 void bc_num_add(BcNum *a, BcNum *b, BcNum *c, size_t scale) {
 	assert(BC_NUM_RDX_VALID(a));
 	assert(BC_NUM_RDX_VALID(b));
+	if (bc_num_asSmall(a, b, c, false)) return;
+	if (bc_num_asInPlace(a, b, c, false, scale)) return;
 	bc_num_binary(a, b, c, false, bc_num_as, bc_num_addReq(a, b, scale));
 }
 
 void bc_num_sub(BcNum *a, BcNum *b, BcNum *c, size_t scale) {
 	assert(BC_NUM_RDX_VALID(a));
 	assert(BC_NUM_RDX_VALID(b));
+	if (bc_num_asSmall(a, b, c, true)) return;
+	if (bc_num_asInPlace(a, b, c, true, scale)) return;
 	bc_num_binary(a, b, c, true, bc_num_as, bc_num_addReq(a, b, scale));
 }
 
 void bc_num_mul(BcNum *a, BcNum *b, BcNum *c, size_t scale) {
 	assert(BC_NUM_RDX_VALID(a));
 	assert(BC_NUM_RDX_VALID(b));
+	if (bc_num_mSmall(a, b, c)) return;
 	bc_num_binary(a, b, c, scale, bc_num_m, bc_num_mulReq(a, b, scale));
 }
 
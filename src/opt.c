@@ -128,6 +128,21 @@ static int bc_opt_parseShort(BcOpt *o, const BcOptLong *longopts) {
 			break;
 		}
 
+		case BC_OPT_REQUIRED_BC_ONLY:
+		{
+			if (BC_IS_DC) {
+
+				char str[2] = {0, 0};
+
+				str[0] = option[0];
+				o->optind += 1;
+
+				bc_opt_error(BC_ERR_FATAL_OPTION, option[0], str);
+			}
+		}
+		// Fallthrough.
+		BC_FALLTHROUGH
+
 		case BC_OPT_REQUIRED:
 		{
 			o->subopt = 0;
@@ -215,6 +230,7 @@ int bc_opt_parse(BcOpt *o, const BcOptLong *longopts) {
 			arg = bc_opt_longoptsArg(option);
 
 			if ((longopts[i].type == BC_OPT_BC_ONLY && BC_IS_DC) ||
+			    (longopts[i].type == BC_OPT_REQUIRED_BC_ONLY && BC_IS_DC) ||
 			    (longopts[i].type == BC_OPT_DC_ONLY && BC_IS_BC))
 			{
 				bc_opt_error(BC_ERR_FATAL_OPTION, o->optopt, name);
@@ -226,8 +242,9 @@ int bc_opt_parse(BcOpt *o, const BcOptLong *longopts) {
 			}
 
 			if (arg != NULL) o->optarg = arg;
-			else if (longopts[i].type == BC_OPT_REQUIRED) {
-
+			else if (longopts[i].type == BC_OPT_REQUIRED ||
+			         longopts[i].type == BC_OPT_REQUIRED_BC_ONLY)
+			{
 				o->optarg = o->argv[o->optind];
 
 				if (o->optarg != NULL) o->optind += 1;
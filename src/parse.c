@@ -84,6 +84,7 @@ static void bc_parse_addNum(BcParse *p, const char *string) {
 
 	BcVec *consts = &p->func->consts;
 	size_t idx;
+	size_t i;
 	BcConst c;
 
 	if (bc_parse_zero[0] == string[0] && bc_parse_zero[1] == string[1]) {
@@ -100,9 +101,13 @@ static void bc_parse_addNum(BcParse *p, const char *string) {
 	BC_SIG_LOCK;
 
 	c.val = bc_vm_strdup(string);
-	c.base = BC_NUM_BIGDIG_MAX;
+#if BC_ENABLED
+	c.fold = 0;
+#endif // BC_ENABLED
+	c.nbases = 0;
+
+	for (i = 0; i < BC_CONST_BASES; ++i) bc_num_clear(c.nums + i);
 
-	bc_num_clear(&c.num);
 	bc_vec_push(consts, &c);
 
 	bc_parse_update(p, BC_INST_NUM, idx);
@@ -183,6 +188,8 @@ void bc_parse_free(BcParse *p) {
 		bc_vec_free(&p->conds);
 		bc_vec_free(&p->ops);
 		bc_vec_free(&p->buf);
+		bc_vec_free(&p->opt);
+		bc_vec_free(&p->offs);
 	}
 #endif // BC_ENABLED
 
@@ -207,7 +214,11 @@ void bc_parse_init(BcParse *p, BcProgram *prog, size_t func) {
 		bc_vec_init(&p->conds, sizeof(size_t), NULL);
 		bc_vec_init(&p->ops, sizeof(BcLexType), NULL);
 		bc_vec_init(&p->buf, sizeof(char), NULL);
+		bc_vec_init(&p->opt, sizeof(uchar), NULL);
+		bc_vec_init(&p->offs, sizeof(size_t), NULL);
 	}
+
+	p->lib = false;
 #endif // BC_ENABLED
 
 	bc_lex_init(&p->l);
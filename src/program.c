@@ -34,7 +34,9 @@
  */
 
 #include <assert.h>
+#include <ctype.h>
 #include <stdbool.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <setjmp.h>
@@ -50,6 +52,10 @@
 
 static void bc_program_addFunc(BcProgram *p, BcFunc *f, BcId *id_ptr);
 
+#if BC_ENABLED
+static void bc_program_fold(BcProgram *p, BcConst *c, BcBigDig base);
+#endif // BC_ENABLED
+
 static inline void bc_program_setVecs(BcProgram *p, BcFunc *f) {
 	p->consts = &f->consts;
 	if (BC_IS_BC) p->strs = &f->strs;
@@ -76,19 +82,88 @@ static void bc_program_type_match(BcResult *r, BcType t) {
 }
 #endif // BC_ENABLED
 
-static size_t bc_program_index(const char *restrict code, size_t *restrict bgn)
+static inline size_t bc_program_index(const char *restrict code,
+                                      size_t *restrict bgn)
 {
-	uchar amt = (uchar) code[(*bgn)++], i = 0;
-	size_t res = 0;
+	size_t res;
 
-	for (; i < amt; ++i, ++(*bgn)) {
-		size_t temp = ((size_t) ((int) (uchar) code[*bgn]) & UCHAR_MAX);
-		res |= (temp << (i * CHAR_BIT));
-	}
+	memcpy(&res, code + *bgn, BC_VEC_INDEX_SIZE);
+	*bgn += BC_VEC_INDEX_SIZE;
 
 	return res;
 }
 
+#if BC_PROG_PROFILE
+// The time stamp counter is the cheapest clock there is, and it is fine for
+// comparing instructions with each other. Elsewhere, a monotonic clock has to
+// do.
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define BC_PROG_TICKS "cycles"
+#define bc_program_ticks() ((uint64_t) __builtin_ia32_rdtsc())
+#else // x86
+#define BC_PROG_TICKS "ns"
+static uint64_t bc_program_ticks(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * UINT64_C(1000000000) + (uint64_t) ts.tv_nsec;
+}
+#endif // x86
+
+static BcProfFunc* bc_program_profFunc(BcProf *prof, size_t fidx) {
+
+	if (fidx >= prof->fns.len) {
+
+		BcProfFunc f;
+
+		memset(&f, 0, sizeof(BcProfFunc));
+
+		while (prof->fns.len <= fidx) bc_vec_push(&prof->fns, &f);
+	}
+
+	return bc_vec_item(&prof->fns, fidx);
+}
+
+static void bc_program_profNums(BcProf *prof, const BcNum *n1,
+                                const BcNum *n2)
+{
+	BcProfInst *i = prof->insts + prof->inst;
+	size_t max = BC_MAX(n1->len, n2->len);
+
+	i->nums += 2;
+	i->limbs += n1->len + n2->len;
+	if (max > i->max) i->max = max;
+}
+
+static void bc_program_profStop(BcProf *prof) {
+
+	uint64_t ticks;
+
+	if (!prof->running) return;
+
+	ticks = bc_program_ticks() - prof->last;
+
+	prof->insts[prof->inst].ticks += ticks;
+	bc_program_profFunc(prof, prof->func)->ticks += ticks;
+	prof->running = false;
+}
+
+static void bc_program_profInst(BcProf *prof, size_t fidx, uchar inst) {
+
+	bc_program_profStop(prof);
+
+	prof->insts[inst].count += 1;
+	bc_program_profFunc(prof, fidx)->insts += 1;
+
+	prof->inst = inst;
+	prof->func = fidx;
+	prof->running = true;
+
+	// This is read last so that the profiler does not charge itself.
+	prof->last = bc_program_ticks();
+}
+#endif // BC_PROG_PROFILE
+
 #if BC_ENABLED
 static void bc_program_prepGlobals(BcProgram *p) {
 
@@ -133,43 +208,120 @@ static void bc_program_pushBigdig(BcProgram *p, BcBigDig dig, BcResultType type)
 }
 
 #if BC_ENABLED
-static BcVec* bc_program_dereference(const BcProgram *p, BcVec *vec) {
+static BcVec* bc_program_arrayAt(const BcProgram *p, BcLoc *loc) {
 
-	BcVec *v;
-	size_t vidx, nidx, i = 0;
+	BcVec *v = bc_vec_item(bc_vec_item(&p->arrs, loc->loc), loc->idx);
 
-	assert(vec->size == sizeof(uchar));
+	// References point to another array, and loc becomes its position.
+	if (v->size == sizeof(uchar)) {
 
-	vidx = bc_program_index(vec->v, &i);
-	nidx = bc_program_index(vec->v, &i);
+		size_t i = 0;
 
-	v = bc_vec_item(bc_vec_item(&p->arrs, vidx), nidx);
+		loc->loc = bc_program_index(v->v, &i);
+		loc->idx = bc_program_index(v->v, &i);
+
+		v = bc_vec_item(bc_vec_item(&p->arrs, loc->loc), loc->idx);
+	}
 
 	assert(v->size != sizeof(uchar));
 
 	return v;
 }
+
+static void bc_program_unshare(BcProgram *p, BcVec *v) {
+
+	BcLoc *loc = bc_vec_item(v, 0);
+	BcVec *src, copy;
+
+	assert(v->size == sizeof(BcLoc));
+
+	src = bc_vec_item(bc_vec_item(&p->arrs, loc->loc), loc->idx);
+
+	assert(src->size == sizeof(BcNum) || BC_ARRAY_SPARSE(src));
+
+	BC_SIG_LOCK;
+
+	bc_array_init(&copy, true);
+	bc_array_copy(&copy, src);
+
+	bc_vec_free(v);
+	memcpy(v, &copy, sizeof(BcVec));
+
+	BC_SIG_UNLOCK;
+}
+
+static void bc_program_unshareFrom(BcProgram *p, const BcLoc *src) {
+
+	size_t i;
+
+	for (i = 0; i < p->shared.len; ++i) {
+
+		BcLoc *loc = bc_vec_item(&p->shared, i);
+		BcVec *v = bc_vec_item(bc_vec_item(&p->arrs, loc->loc), loc->idx);
+
+		if (v->size == sizeof(BcLoc)) {
+			loc = bc_vec_item(v, 0);
+			if (loc->loc == src->loc && loc->idx == src->idx)
+				bc_program_unshare(p, v);
+		}
+	}
+}
+
+/**
+ * Returns the array that array idx currently names. An array passed by value
+ * only holds the position of the array it was passed from (as a BcLoc) and
+ * reads go there, until either of them is written. If write is true, that
+ * sharing is undone first.
+ */
+static BcVec* bc_program_array(BcProgram *p, size_t idx, bool write) {
+
+	BcVec *v = bc_vec_item(&p->arrs, idx);
+	BcLoc loc;
+
+	loc.loc = idx;
+	loc.idx = v->len - 1;
+
+	v = bc_program_arrayAt(p, &loc);
+
+	if (v->size == sizeof(BcLoc)) {
+
+		if (!write) {
+			BcLoc *src = bc_vec_item(v, 0);
+			return bc_vec_item(bc_vec_item(&p->arrs, src->loc), src->idx);
+		}
+
+		bc_program_unshare(p, v);
+	}
+	else if (write && p->shared.len) bc_program_unshareFrom(p, &loc);
+
+	assert(v->size == sizeof(BcNum) || BC_ARRAY_SPARSE(v));
+
+	return v;
+}
 #endif // BC_ENABLED
 
 size_t bc_program_search(BcProgram *p, const char *id, bool var) {
 
-	BcVec *v, *map;
+	BcVec *v;
+	BcMap *map;
 	size_t i;
 	BcResultData data;
+	sig_atomic_t lock;
 
 	v = var ? &p->vars : &p->arrs;
 	map = var ? &p->var_map : &p->arr_map;
 
-	BC_SIG_LOCK;
+	// Saved code is loaded with signals already locked.
+	BC_SIG_TRYLOCK(lock);
 
 	if (bc_map_insert(map, id, v->len, &i)) {
 		bc_array_init(&data.v, var);
 		bc_vec_push(v, &data.v);
 	}
 
-	BC_SIG_UNLOCK;
+	BC_SIG_TRYUNLOCK(lock);
 
-	return ((BcId*) bc_vec_item(map, i))->idx;
+	return bc_map_item(map, i)->idx;
 }
 
 static inline BcVec* bc_program_vec(const BcProgram *p, size_t idx, BcType type)
@@ -186,6 +338,7 @@ static BcNum* bc_program_num(BcProgram *p, BcResult *r) {
 
 		case BC_RESULT_STR:
 		case BC_RESULT_TEMP:
+		case BC_RESULT_CONST:
 		case BC_RESULT_IBASE:
 		case BC_RESULT_SCALE:
 		case BC_RESULT_OBASE:
@@ -212,21 +365,25 @@ static BcNum* bc_program_num(BcProgram *p, BcResult *r) {
 
 				size_t idx = r->d.loc.idx;
 
+#if BC_ENABLED
+				v = bc_program_array(p, r->d.loc.loc, false);
+#else // BC_ENABLED
 				v = bc_vec_top(v);
+#endif // BC_ENABLED
+
+				n = bc_array_find(v, idx);
+
+				// Adding the element to the array is a write.
+				if (n == NULL) {
 
 #if BC_ENABLED
-				if (v->size == sizeof(uchar)) v = bc_program_dereference(p, v);
+					v = bc_program_array(p, r->d.loc.loc, true);
 #endif // BC_ENABLED
 
-				assert(v->size == sizeof(BcNum));
-
-				if (v->len <= idx) {
 					BC_SIG_LOCK;
-					bc_array_expand(v, bc_vm_growSize(idx, 1));
+					n = bc_array_item(v, idx);
 					BC_SIG_UNLOCK;
 				}
-
-				n = bc_vec_item(v, idx);
 			}
 			else n = bc_vec_top(v);
 
@@ -307,6 +464,10 @@ static void bc_program_binPrep(BcProgram *p, BcResult **l, BcNum **ln,
 		*ln = bc_program_num(p, *l);
 
 	if (BC_ERR(lt == BC_RESULT_STR)) bc_vm_err(BC_ERR_EXEC_TYPE);
+
+#if BC_PROG_PROFILE
+	if (p->prof != NULL) bc_program_profNums(p->prof, *ln, *rn);
+#endif // BC_PROG_PROFILE
 }
 
 static void bc_program_binOpPrep(BcProgram *p, BcResult **l, BcNum **ln,
@@ -324,6 +485,16 @@ static void bc_program_assignPrep(BcProgram *p, BcResult **l, BcNum **ln,
 
 	min = BC_RESULT_TEMP - ((unsigned int) (BC_IS_BC));
 
+#if BC_ENABLED
+	if (BC_IS_BC) {
+
+		BcResult *left = bc_vec_item_rev(&p->results, 1);
+
+		if (left->t == BC_RESULT_ARRAY_ELEM)
+			bc_program_array(p, left->d.loc.loc, true);
+	}
+#endif // BC_ENABLED
+
 	bc_program_binPrep(p, l, ln, r, rn, 0);
 
 	lt = (*l)->t;
@@ -378,29 +549,49 @@ static BcResult* bc_program_prepResult(BcProgram *p) {
 
 static void bc_program_const(BcProgram *p, const char *code, size_t *bgn) {
 
-	BcResult *r = bc_program_prepResult(p);
+	BcResult *r;
 	BcConst *c = bc_vec_item(p->consts, bc_program_index(code, bgn));
 	BcBigDig base = BC_PROG_IBASE(p);
+	size_t i;
 
-	if (c->base != base) {
+	for (i = 0; i < c->nbases && c->bases[i] != base; ++i);
 
-		if (c->num.num == NULL) {
+#if BC_ENABLED
+	if (c->fold && i == c->nbases) {
+		bc_program_fold(p, c, base);
+		return;
+	}
+#endif // BC_ENABLED
+
+	r = bc_program_prepResult(p);
+
+	if (i == c->nbases) {
+
+		// Parses are kept for the first few bases a constant is used with, so
+		// switching ibase back and forth does not reparse. Past that, the
+		// constant is parsed straight into the result.
+		BcNum *n = i < BC_CONST_BASES ? c->nums + i : &r->d.n;
+
+		if (n->num == NULL) {
 			BC_SIG_LOCK;
-			bc_num_init(&c->num, BC_NUM_RDX(strlen(c->val)));
+			bc_num_init(n, BC_NUM_RDX(strlen(c->val)));
 			BC_SIG_UNLOCK;
 		}
+		else bc_num_zero(n);
 
 		// bc_num_parse() should only do operations that cannot fail.
-		bc_num_parse(&c->num, c->val, base);
-
-		c->base = base;
-	}
+		bc_num_parse(n, c->val, base);
 
-	BC_SIG_LOCK;
+		if (n == &r->d.n) return;
 
-	bc_num_createCopy(&r->d.n, &c->num);
+		c->bases[i] = base;
+		c->nbases += 1;
+	}
 
-	BC_SIG_UNLOCK;
+	// Cached parses are never changed once made, and nothing writes to an
+	// operand, so the result can borrow the digits instead of copying them.
+	r->t = BC_RESULT_CONST;
+	memcpy(&r->d.n, c->nums + i, sizeof(BcNum));
 }
 
 static void bc_program_op(BcProgram *p, uchar inst) {
@@ -646,71 +837,119 @@ static void bc_program_unary(BcProgram *p, uchar inst) {
 	bc_program_retire(p, 1, 1);
 }
 
-static void bc_program_logical(BcProgram *p, uchar inst) {
+#if BC_ENABLED
+static void bc_program_fold(BcProgram *p, BcConst *c, BcBigDig base) {
 
-	BcResult *opd1, *opd2, *res;
-	BcNum *n1, *n2;
-	bool cond = 0;
-	ssize_t cmp;
+	BcResult *r;
+	size_t idx = 0;
 
-	res = bc_program_prepResult(p);
+	assert(c->nbases <= BC_CONST_BASES);
 
-	bc_program_binOpPrep(p, &opd1, &n1, &opd2, &n2, 1);
+	// The code of a folded constant only has constants and operators whose
+	// results do not depend on scale, so it gives the same value every time it
+	// runs with the same ibase.
+	while (idx < c->fold) {
 
-	if (inst == BC_INST_BOOL_AND)
-		cond = (bc_num_cmpZero(n1) && bc_num_cmpZero(n2));
-	else if (inst == BC_INST_BOOL_OR)
-		cond = (bc_num_cmpZero(n1) || bc_num_cmpZero(n2));
-	else {
+		uchar inst = (uchar) c->val[idx++];
 
-		cmp = bc_num_cmp(n1, n2);
+		if (inst == BC_INST_NUM) bc_program_const(p, c->val, &idx);
+		else if (inst == BC_INST_ZERO || inst == BC_INST_ONE) {
+			BcResult res;
+			res.t = BC_RESULT_ZERO + (inst - BC_INST_ZERO);
+			bc_vec_push(&p->results, &res);
+		}
+		else if (inst == BC_INST_NEG) bc_program_unary(p, inst);
+		else bc_program_op(p, inst);
+	}
 
-		switch (inst) {
+	if (c->nbases == BC_CONST_BASES) return;
 
-			case BC_INST_REL_EQ:
-			{
-				cond = (cmp == 0);
-				break;
-			}
+	r = bc_vec_top(&p->results);
 
-			case BC_INST_REL_LE:
-			{
-				cond = (cmp <= 0);
-				break;
-			}
+	assert(r->t == BC_RESULT_TEMP);
+	assert(c->nums[c->nbases].num == NULL);
 
-			case BC_INST_REL_GE:
-			{
-				cond = (cmp >= 0);
-				break;
-			}
+	BC_SIG_LOCK;
 
-			case BC_INST_REL_NE:
-			{
-				cond = (cmp != 0);
-				break;
-			}
+	// The digits now belong to the constant.
+	memcpy(c->nums + c->nbases, &r->d.n, sizeof(BcNum));
+	c->bases[c->nbases] = base;
+	c->nbases += 1;
 
-			case BC_INST_REL_LT:
-			{
-				cond = (cmp < 0);
-				break;
-			}
+	r->t = BC_RESULT_CONST;
 
-			case BC_INST_REL_GT:
-			{
-				cond = (cmp > 0);
-				break;
-			}
+	BC_SIG_UNLOCK;
+}
+#endif // BC_ENABLED
+
+static bool bc_program_rel(uchar inst, ssize_t cmp) {
+
+	bool cond = false;
+
+	switch (inst) {
+
+		case BC_INST_REL_EQ:
+		{
+			cond = (cmp == 0);
+			break;
+		}
+
+		case BC_INST_REL_LE:
+		{
+			cond = (cmp <= 0);
+			break;
+		}
+
+		case BC_INST_REL_GE:
+		{
+			cond = (cmp >= 0);
+			break;
+		}
+
+		case BC_INST_REL_NE:
+		{
+			cond = (cmp != 0);
+			break;
+		}
+
+		case BC_INST_REL_LT:
+		{
+			cond = (cmp < 0);
+			break;
+		}
+
+		case BC_INST_REL_GT:
+		{
+			cond = (cmp > 0);
+			break;
+		}
 #ifndef NDEBUG
-			default:
-			{
-				abort();
-			}
-#endif // NDEBUG
+		default:
+		{
+			abort();
 		}
+#endif // NDEBUG
 	}
 
+	return cond;
+}
+
+static void bc_program_logical(BcProgram *p, uchar inst) {
+
+	BcResult *opd1, *opd2, *res;
+	BcNum *n1, *n2;
+	bool cond = 0;
+
+	res = bc_program_prepResult(p);
+
+	bc_program_binOpPrep(p, &opd1, &n1, &opd2, &n2, 1);
+
+	if (inst == BC_INST_BOOL_AND)
+		cond = (bc_num_cmpZero(n1) && bc_num_cmpZero(n2));
+	else if (inst == BC_INST_BOOL_OR)
+		cond = (bc_num_cmpZero(n1) || bc_num_cmpZero(n2));
+	else cond = bc_program_rel(inst, bc_num_cmp(n1, n2));
+
 	BC_SIG_LOCK;
 
 	bc_num_init(&res->d.n, BC_NUM_DEF_SIZE);
@@ -799,7 +1038,7 @@ static void bc_program_copyToVar(BcProgram *p, size_t idx,
 		if (!last) v = bc_vec_item_rev(parent, !last);
 		assert(v != NULL);
 
-		ref = (v->size == sizeof(BcNum) && t == BC_TYPE_REF);
+		ref = (v->size != sizeof(uchar) && t == BC_TYPE_REF);
 		ref_size = (v->size == sizeof(uchar));
 
 		if (ref || (ref_size && t == BC_TYPE_REF)) {
@@ -826,7 +1065,32 @@ static void bc_program_copyToVar(BcProgram *p, size_t idx,
 			BC_SIG_UNLOCK;
 			return;
 		}
-		else if (ref_size && t != BC_TYPE_REF) v = bc_program_dereference(p, v);
+		else if (BC_IS_BC) {
+
+			BcLoc loc;
+
+			loc.loc = ptr->d.loc.loc;
+			loc.idx = parent->len - !last - 1;
+
+			v = bc_program_arrayAt(p, &loc);
+
+			// Instead of a copy, the parameter gets the position of the array
+			// to share with. See bc_program_array().
+			if (v->size == sizeof(BcLoc)) loc = *((BcLoc*) bc_vec_item(v, 0));
+
+			bc_vec_init(rv, sizeof(BcLoc), NULL);
+			bc_vec_push(rv, &loc);
+
+			loc.loc = idx;
+			loc.idx = vec->len;
+			bc_vec_push(&p->shared, &loc);
+
+			bc_vec_push(vec, &r.d);
+			bc_vec_pop(&p->results);
+
+			BC_SIG_UNLOCK;
+			return;
+		}
 #endif // BC_ENABLED
 
 		bc_array_init(rv, true);
@@ -1003,6 +1267,9 @@ static void bc_program_pushArray(BcProgram *p, const char *restrict code,
 	bc_program_prep(p, &operand, &num, 0);
 	bc_num_bigdig(num, &temp);
 
+	// The index one past BC_MAX_DIM marks empty slots in sparse arrays.
+	if (BC_ERR(temp > BC_MAX_DIM)) bc_vm_err(BC_ERR_MATH_OVERFLOW);
+
 	r.t = BC_RESULT_ARRAY_ELEM;
 	r.d.loc.idx = (size_t) temp;
 
@@ -1055,29 +1322,391 @@ exit:
 	BC_LONGJMP_CONT;
 }
 
+static void bc_program_assignVar(BcProgram *p, const char *restrict code,
+                                 size_t *restrict bgn, uchar inst)
+{
+	BcNum *l, *r = &p->one;
+	bool var = (inst == BC_INST_ASSIGN_VAR);
+
+	// The fused forms only ever have plain variables as operands, so there is
+	// nothing to check, and the operands do not need to be pushed as results.
+	if (var) inst = (uchar) code[(*bgn)++];
+	else inst = BC_INST_ASSIGN_PLUS_NO_VAL + (inst != BC_INST_INC_VAR);
+
+	l = bc_vec_top(bc_program_vec(p, bc_program_index(code, bgn), BC_TYPE_VAR));
+
+	if (var)
+		r = bc_vec_top(bc_program_vec(p, bc_program_index(code, bgn),
+		                              BC_TYPE_VAR));
+
+	assert(BC_NUM_RDX_VALID(l));
+	assert(BC_NUM_RDX_VALID(r));
+
+	if (inst == BC_INST_ASSIGN_NO_VAL) bc_num_copy(l, r);
+	else {
+
+		size_t idx = inst - BC_INST_ASSIGN_POWER_NO_VAL;
+
+#if BC_PROG_PROFILE
+		if (p->prof != NULL) bc_program_profNums(p->prof, l, r);
+#endif // BC_PROG_PROFILE
+
+		bc_program_ops[idx](l, r, l, BC_PROG_SCALE(p));
+	}
+}
+
+static bool bc_program_relVarNum(BcProgram *p, const char *restrict code,
+                                 size_t *restrict bgn)
+{
+	BcResult *res = NULL;
+	BcConst *c;
+	BcNum *l, *r;
+	BcBigDig base = BC_PROG_IBASE(p);
+	uchar inst = (uchar) code[(*bgn)++];
+	size_t i, cidx;
+	bool cond;
+
+	l = bc_vec_top(bc_program_vec(p, bc_program_index(code, bgn), BC_TYPE_VAR));
+
+	cidx = *bgn;
+	c = bc_vec_item(p->consts, bc_program_index(code, bgn));
+
+	for (i = 0; i < c->nbases && c->bases[i] != base; ++i);
+
+	// Only a constant that has not been parsed with this ibase yet needs to go
+	// through a result.
+	if (i < c->nbases) r = c->nums + i;
+	else {
+		bc_program_const(p, code, &cidx);
+		res = bc_vec_top(&p->results);
+		r = &res->d.n;
+	}
+
+	cond = bc_program_rel(inst, bc_num_cmp(l, r));
+
+	if (res != NULL) bc_vec_pop(&p->results);
+
+	return cond;
+}
+
+static void bc_program_libCacheFree(void *cache) {
+
+	BcLibCache *c = (BcLibCache*) cache;
+
+	BC_SIG_ASSERT_LOCKED;
+
+	bc_num_free(&c->arg);
+	bc_num_free(&c->res);
+}
+
+static bool bc_program_libCache(BcProgram *p, size_t fidx) {
+
+	BcLibCache *c, pend;
+	BcResult *res;
+	BcNum *n = bc_program_num(p, bc_vec_top(&p->results));
+	BcBigDig scale = BC_PROG_SCALE(p);
+	size_t i;
+
+	for (i = 0; i < p->lib_cache.len; ++i) {
+
+		c = bc_vec_item(&p->lib_cache, i);
+
+		if (c->fidx == fidx && c->scale == scale &&
+		    c->arg.scale == n->scale && !bc_num_cmp(&c->arg, n))
+		{
+			BC_SIG_LOCK;
+
+			bc_vec_pop(&p->results);
+			res = bc_program_prepResult(p);
+			bc_num_createCopy(&res->d.n, &c->res);
+
+			BC_SIG_UNLOCK;
+
+			return true;
+		}
+	}
+
+	// The result is filled in by bc_program_return() when the frame that is
+	// about to be pushed is popped.
+	pend.fidx = fidx;
+	pend.depth = p->stack.len + 1;
+	pend.scale = scale;
+	bc_num_clear(&pend.res);
+
+	BC_SIG_LOCK;
+
+	bc_num_createCopy(&pend.arg, n);
+	bc_vec_push(&p->lib_pend, &pend);
+
+	BC_SIG_UNLOCK;
+
+	return false;
+}
+
+static void bc_program_libCacheRet(BcProgram *p, const BcNum *n) {
+
+	BcLibCache *c;
+
+	if (!p->lib_pend.len) return;
+
+	c = bc_vec_top(&p->lib_pend);
+
+	if (c->depth != p->stack.len) return;
+
+	BC_SIG_LOCK;
+
+	if (n != NULL && p->lib_cache.len < BC_PROG_LIB_CACHE_MAX) {
+		bc_num_createCopy(&c->res, n);
+		bc_vec_push(&p->lib_cache, c);
+		bc_num_clear(&c->arg);
+		bc_num_clear(&c->res);
+	}
+
+	bc_vec_pop(&p->lib_pend);
+
+	BC_SIG_UNLOCK;
+}
+
+static BcPureEntry* bc_program_pureSlot(const BcPure *c, size_t hash,
+                                        const char *key, size_t len)
+{
+	size_t i, mask = c->cap - 1;
+	BcPureEntry *e;
+
+	for (i = hash & mask; (e = c->table + i)->key != NULL; i = (i + 1) & mask)
+	{
+		if (e->hash == hash && e->len == len && !memcmp(e->key, key, len))
+			break;
+	}
+
+	return e;
+}
+
+static void bc_program_pureFree(void *entry) {
+
+	BcPureEntry *e = (BcPureEntry*) entry;
+
+	BC_SIG_ASSERT_LOCKED;
+
+	free(e->key);
+	if (e->res.num != NULL) bc_num_free(&e->res);
+}
+
+static void bc_program_pureFlush(BcPure *c) {
+
+	size_t i;
+
+	BC_SIG_ASSERT_LOCKED;
+
+	if (!c->used) return;
+
+	for (i = 0; i < c->cap; ++i) {
+		if (c->table[i].key == NULL) continue;
+		bc_program_pureFree(c->table + i);
+		c->table[i].key = NULL;
+	}
+
+	c->used = 0;
+	c->flushes += 1;
+}
+
+static void bc_program_pureAlloc(BcPure *c, size_t cap) {
+
+	size_t i;
+
+	assert(cap && !(cap & (cap - 1)));
+
+	c->cap = cap;
+	c->table = bc_vm_malloc(bc_vm_arraySize(cap, sizeof(BcPureEntry)));
+
+	for (i = 0; i < cap; ++i) c->table[i].key = NULL;
+}
+
+static void bc_program_pureAdd(BcPure *c, BcPureEntry *pend) {
+
+	BcPureEntry *e;
+
+	BC_SIG_ASSERT_LOCKED;
+
+	// Rather than keep track of which results are used, a full table is just
+	// started over.
+	if (c->used >= BC_PROG_PURE_MAX) bc_program_pureFlush(c);
+
+	if (!c->cap) bc_program_pureAlloc(c, 64);
+	else if (BC_VEC_HASH_FULL(c->used, c->cap)) {
+
+		BcPureEntry *old = c->table;
+		size_t i, cap = c->cap;
+
+		bc_program_pureAlloc(c, bc_vm_growSize(cap, cap));
+
+		for (i = 0; i < cap; ++i) {
+			if (old[i].key == NULL) continue;
+			e = bc_program_pureSlot(c, old[i].hash, old[i].key, old[i].len);
+			memcpy(e, old + i, sizeof(BcPureEntry));
+		}
+
+		free(old);
+	}
+
+	e = bc_program_pureSlot(c, pend->hash, pend->key, pend->len);
+
+	// A call that was running when the same call finished is a duplicate.
+	if (e->key != NULL) return;
+
+	memcpy(e, pend, sizeof(BcPureEntry));
+	c->used += 1;
+
+	pend->key = NULL;
+	bc_num_clear(&pend->res);
+}
+
+static bool bc_program_pure(BcProgram *p, size_t fidx, size_t nparams,
+                            bool tail)
+{
+	BcPure *c = &p->pure;
+	BcPureEntry *e, pend;
+	BcResult *res;
+	size_t i;
+
+	bc_vec_npop(&c->key, c->key.len);
+	bc_vec_npush(&c->key, sizeof(size_t), &fidx);
+	bc_vec_npush(&c->key, sizeof(BcBigDig), p->globals + BC_PROG_GLOBALS_SCALE);
+	bc_vec_npush(&c->key, sizeof(BcBigDig), p->globals + BC_PROG_GLOBALS_IBASE);
+
+	for (i = 0; i < nparams; ++i) {
+
+		BcNum *n;
+
+		res = bc_vec_item_rev(&p->results, nparams - 1 - i);
+
+		// Let bc_program_call() report these.
+		if (res->t == BC_RESULT_VOID || res->t == BC_RESULT_ARRAY ||
+		    res->t == BC_RESULT_STR)
+		{
+			return false;
+		}
+
+		n = bc_program_num(p, res);
+
+		bc_vec_npush(&c->key, sizeof(size_t), &n->rdx);
+		bc_vec_npush(&c->key, sizeof(size_t), &n->scale);
+		bc_vec_npush(&c->key, sizeof(size_t), &n->len);
+		if (n->len) bc_vec_npush(&c->key, n->len * sizeof(BcDig), n->num);
+	}
+
+	pend.hash = bc_vec_hash(BC_VEC_HASH_INIT, c->key.v, c->key.len);
+	pend.len = c->key.len;
+
+	if (c->used) {
+
+		e = bc_program_pureSlot(c, pend.hash, c->key.v, pend.len);
+
+		if (e->key != NULL) {
+
+			BC_SIG_LOCK;
+
+			bc_vec_npop(&p->results, nparams);
+			res = bc_program_prepResult(p);
+			bc_num_createCopy(&res->d.n, &e->res);
+
+			BC_SIG_UNLOCK;
+
+			c->hits += 1;
+
+			return true;
+		}
+	}
+
+	c->misses += 1;
+
+	// A tail call reuses the frame of its caller, so both return together.
+	pend.depth = p->stack.len + !tail;
+	bc_num_clear(&pend.res);
+
+	BC_SIG_LOCK;
+
+	pend.key = bc_vm_malloc(pend.len);
+	memcpy(pend.key, c->key.v, pend.len);
+	bc_vec_push(&c->pend, &pend);
+
+	BC_SIG_UNLOCK;
+
+	return false;
+}
+
+static void bc_program_pureRet(BcProgram *p, const BcNum *n) {
+
+	BcPure *c = &p->pure;
+	BcPureEntry *e;
+
+	BC_SIG_LOCK;
+
+	while (c->pend.len && (e = bc_vec_top(&c->pend))->depth == p->stack.len) {
+
+		if (n != NULL) {
+			bc_num_createCopy(&e->res, n);
+			bc_program_pureAdd(c, e);
+		}
+
+		bc_vec_pop(&c->pend);
+	}
+
+	BC_SIG_UNLOCK;
+}
+
 static void bc_program_call(BcProgram *p, const char *restrict code,
-                            size_t *restrict idx)
+                            size_t *restrict idx, uchar inst)
 {
-	BcInstPtr ip;
+	BcInstPtr ip, *caller = bc_vec_top(&p->stack);
 	size_t i, nparams = bc_program_index(code, idx);
 	BcFunc *f;
 	BcVec *v;
 	BcLoc *a;
 	BcResultData param;
 	BcResult *arg;
+	bool tail;
 
 	ip.idx = 0;
 	ip.func = bc_program_index(code, idx);
 	f = bc_vec_item(&p->fns, ip.func);
 
-	if (BC_ERR(!f->code.len)) bc_vm_verr(BC_ERR_EXEC_UNDEF_FUNC, f->name);
+#if BC_PROG_PROFILE
+	if (p->prof != NULL) bc_program_profFunc(p->prof, ip.func)->calls += 1;
+#endif // BC_PROG_PROFILE
+
+	if (BC_ERR(!f->code.len)) {
+		if (f->saved == NULL) bc_vm_verr(BC_ERR_EXEC_UNDEF_FUNC, f->name);
+		bc_bytecode_loadSaved(f);
+	}
+
 	if (BC_ERR(nparams != f->nparams))
 		bc_vm_verr(BC_ERR_EXEC_PARAMS, f->nparams, nparams);
 	ip.len = p->results.len - nparams;
 
 	assert(BC_PROG_STACK(&p->results, nparams));
 
-	if (BC_G) bc_program_prepGlobals(p);
+	if (inst == BC_INST_CALL_CONST && f->lib && !f->voidfn &&
+	    bc_program_libCache(p, ip.func))
+	{
+		return;
+	}
+
+	// A tail call can take over the frame of its caller only if it is a call
+	// to the same function, because then the new autos hide all of the old
+	// ones, and only if no array is passed, because that could refer to one
+	// of the old autos. Library functions are left alone for their cache.
+	tail = (inst == BC_INST_CALL_TAIL && ip.func == caller->func && !f->lib);
+
+	for (i = 0; tail && i < nparams; ++i) {
+		a = bc_vec_item(&f->autos, i);
+		tail = (a->idx == BC_TYPE_VAR);
+	}
+
+	if (f->pure && bc_program_pure(p, ip.func, nparams, tail)) return;
+
+	// The globals that the caller pushed serve the callee just as well.
+	if (BC_G && !tail) bc_program_prepGlobals(p);
 
 	for (i = 0; i < nparams; ++i) {
 
@@ -1120,22 +1749,50 @@ static void bc_program_call(BcProgram *p, const char *restrict code,
 		}
 	}
 
-	bc_vec_push(&p->stack, &ip);
+	if (tail) {
+
+		// The autos of the caller are now just below the top of their stacks.
+		for (i = 0; i < f->autos.len; ++i) {
+			a = bc_vec_item(&f->autos, i);
+			v = bc_program_vec(p, a->loc, (BcType) a->idx);
+			bc_vec_npopAt(v, 1, v->len - 2);
+		}
+
+		ip.len = caller->len;
+
+		memcpy(caller, &ip, sizeof(BcInstPtr));
+	}
+	else bc_vec_push(&p->stack, &ip);
+
+	BC_SIG_UNLOCK;
+}
+
+static void bc_program_popAutos(BcProgram *p, const BcInstPtr *ip) {
+
+	BcFunc *f = bc_vec_item(&p->fns, ip->func);
+	size_t i;
+
+	// We need to pop arguments as well, so this takes that into account.
+	for (i = 0; i < f->autos.len; ++i) {
 
-	BC_SIG_UNLOCK;
+		BcLoc *a = bc_vec_item(&f->autos, i);
+		BcVec *v = bc_program_vec(p, a->loc, (BcType) a->idx);
+
+		bc_vec_pop(v);
+
+		if (i < f->nparams && a->idx == BC_TYPE_ARRAY) bc_vec_pop(&p->shared);
+	}
 }
 
 static void bc_program_return(BcProgram *p, uchar inst) {
 
 	BcResult *res;
-	BcFunc *f;
 	BcInstPtr *ip = bc_vec_top(&p->stack);
-	size_t i, nops = p->results.len - ip->len;
+	size_t nops = p->results.len - ip->len;
 
 	assert(BC_PROG_STACK(&p->stack, 2));
 	assert(BC_PROG_STACK(&p->results, ip->len + (inst == BC_INST_RET)));
 
-	f = bc_vec_item(&p->fns, ip->func);
 	res = bc_program_prepResult(p);
 
 	if (inst == BC_INST_RET) {
@@ -1157,14 +1814,10 @@ static void bc_program_return(BcProgram *p, uchar inst) {
 
 	BC_SIG_MAYUNLOCK;
 
-	// We need to pop arguments as well, so this takes that into account.
-	for (i = 0; i < f->autos.len; ++i) {
-
-		BcLoc *a = bc_vec_item(&f->autos, i);
-		BcVec *v = bc_program_vec(p, a->loc, (BcType) a->idx);
+	bc_program_libCacheRet(p, inst != BC_INST_RET_VOID ? &res->d.n : NULL);
+	bc_program_pureRet(p, inst != BC_INST_RET_VOID ? &res->d.n : NULL);
 
-		bc_vec_pop(v);
-	}
+	bc_program_popAutos(p, ip);
 
 	bc_program_retire(p, 1, nops);
 
@@ -1236,13 +1889,8 @@ static void bc_program_builtin(BcProgram *p, uchar inst) {
 #if BC_ENABLED
 			if (BC_IS_BC && opd->t == BC_RESULT_ARRAY) {
 
-				BcVec *v = (BcVec*) num;
-
-				if (v->size == sizeof(uchar)) v = bc_program_dereference(p, v);
-
-				assert(v->size == sizeof(BcNum));
-
-				val = (BcBigDig) v->len;
+				BcVec *v = bc_program_array(p, opd->d.loc.loc, false);
+				val = (BcBigDig) bc_array_len(v);
 			}
 			else
 #endif // BC_ENABLED
@@ -1560,6 +2208,10 @@ static void bc_program_execStr(BcProgram *p, const char *restrict code,
 	ip.len = p->results.len;
 	ip.func = fidx;
 
+#if BC_PROG_PROFILE
+	if (p->prof != NULL) bc_program_profFunc(p->prof, fidx)->calls += 1;
+#endif // BC_PROG_PROFILE
+
 	bc_vec_pop(&p->results);
 
 	// Tail call.
@@ -1649,13 +2301,31 @@ size_t bc_program_insertFunc(BcProgram *p, const char *name) {
 	assert(p != NULL && name != NULL);
 
 	new = bc_map_insert(&p->fn_map, name, p->fns.len, &idx);
-	id_ptr = (BcId*) bc_vec_item(&p->fn_map, idx);
+	id_ptr = bc_map_item(&p->fn_map, idx);
 	idx = id_ptr->idx;
 
 	if (!new) {
 		if (BC_IS_BC) {
+
 			BcFunc *func = bc_vec_item(&p->fns, idx);
 			bc_func_reset(func);
+
+#if BC_ENABLED
+			// A cached library result may depend on the old definition.
+			bc_vec_npop(&p->lib_cache, p->lib_cache.len);
+
+			// So may any pure result, through any function it calls.
+			bc_program_pureFlush(&p->pure);
+
+#if BC_VM_CACHE
+			if (vm.cache != NULL) bc_bytecode_fileRedef(vm.cache, idx);
+#endif // BC_VM_CACHE
+
+#if BC_VM_SERVER
+			if (vm.server != NULL && idx < vm.server->snap.fns)
+				vm.server->redef = true;
+#endif // BC_VM_SERVER
+#endif // BC_ENABLED
 		}
 	}
 	else {
@@ -1685,16 +2355,25 @@ void bc_program_free(BcProgram *p) {
 	for (i = 0; i < BC_PROG_GLOBALS_LEN; ++i) bc_vec_free(p->globals_v + i);
 
 	bc_vec_free(&p->fns);
-	bc_vec_free(&p->fn_map);
+	bc_map_free(&p->fn_map);
 	bc_vec_free(&p->vars);
-	bc_vec_free(&p->var_map);
+	bc_map_free(&p->var_map);
 	bc_vec_free(&p->arrs);
-	bc_vec_free(&p->arr_map);
+	bc_map_free(&p->arr_map);
 	bc_vec_free(&p->results);
 	bc_vec_free(&p->stack);
 
 #if BC_ENABLED
-	if (BC_IS_BC) bc_num_free(&p->last);
+	if (BC_IS_BC) {
+		bc_num_free(&p->last);
+		bc_vec_free(&p->lib_cache);
+		bc_vec_free(&p->lib_pend);
+		bc_vec_free(&p->shared);
+		bc_program_pureFlush(&p->pure);
+		free(p->pure.table);
+		bc_vec_free(&p->pure.pend);
+		bc_vec_free(&p->pure.key);
+	}
 #endif // BC_ENABLED
 
 #if BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
@@ -1707,6 +2386,13 @@ void bc_program_free(BcProgram *p) {
 		bc_vec_free(&p->strs_v);
 	}
 #endif // DC_ENABLED
+
+#if BC_PROG_PROFILE
+	if (p->prof != NULL) {
+		bc_vec_free(&p->prof->fns);
+		free(p->prof);
+	}
+#endif // BC_PROG_PROFILE
 }
 #endif // NDEBUG
 
@@ -1757,7 +2443,18 @@ void bc_program_init(BcProgram *p) {
 	bc_num_one(&p->one);
 
 #if BC_ENABLED
-	if (BC_IS_BC) bc_num_init(&p->last, BC_NUM_DEF_SIZE);
+	if (BC_IS_BC) {
+		bc_num_init(&p->last, BC_NUM_DEF_SIZE);
+		// Most programs never touch these, so they start out unallocated.
+		bc_vec_initLazy(&p->lib_cache, sizeof(BcLibCache),
+		                bc_program_libCacheFree);
+		bc_vec_initLazy(&p->lib_pend, sizeof(BcLibCache),
+		                bc_program_libCacheFree);
+		bc_vec_initLazy(&p->shared, sizeof(BcLoc), NULL);
+		bc_vec_initLazy(&p->pure.pend, sizeof(BcPureEntry),
+		                bc_program_pureFree);
+		bc_vec_initLazy(&p->pure.key, sizeof(char), NULL);
+	}
 #endif // BC_ENABLED
 
 	bc_vec_init(&p->fns, sizeof(BcFunc), bc_func_free);
@@ -1787,11 +2484,28 @@ void bc_program_reset(BcProgram *p) {
 
 	BC_SIG_ASSERT_LOCKED;
 
+#if BC_ENABLED
+	// The autos of the unwound calls would otherwise stay on their stacks.
+	if (BC_IS_BC) {
+		while (p->stack.len > 1) {
+			bc_program_popAutos(p, bc_vec_top(&p->stack));
+			bc_vec_pop(&p->stack);
+		}
+	}
+#endif // BC_ENABLED
+
 	bc_vec_npop(&p->stack, p->stack.len - 1);
 	bc_vec_npop(&p->results, p->results.len);
 
 #if BC_ENABLED
 	if (BC_G) bc_program_popGlobals(p, true);
+
+	if (BC_IS_BC) {
+		bc_vec_npop(&p->lib_pend, p->lib_pend.len);
+		bc_vec_npop(&p->lib_cache, p->lib_cache.len);
+		bc_vec_npop(&p->shared, p->shared.len);
+		bc_vec_npop(&p->pure.pend, p->pure.pend.len);
+	}
 #endif // BC_ENABLED
 
 	f = bc_vec_item(&p->fns, BC_PROG_MAIN);
@@ -1806,6 +2520,179 @@ void bc_program_reset(BcProgram *p) {
 	}
 }
 
+#if BC_ENABLED && !BC_ENABLE_LIBRARY
+static void bc_program_clearMain(BcProgram *p) {
+
+	BcFunc *f = bc_vec_item(&p->fns, BC_PROG_MAIN);
+	BcInstPtr *ip = bc_vec_top(&p->stack);
+
+	assert(p->stack.len == 1);
+
+	bc_vec_npop(&f->labels, f->labels.len);
+	bc_vec_npop(&f->strs, f->strs.len);
+	bc_vec_npop(&f->consts, f->consts.len);
+	bc_vec_npop(&f->code, f->code.len);
+
+	ip->idx = 0;
+}
+
+static bool bc_program_arrayEmpty(const BcVec *a) {
+	return !BC_ARRAY_SPARSE(a) && a->len == 1 &&
+	       !BC_NUM_NONZERO((BcNum*) bc_vec_item(a, 0));
+}
+
+void bc_program_snap(BcProgram *p, BcProgramSnap *s) {
+
+	size_t i;
+
+	BC_SIG_ASSERT_LOCKED;
+
+	// The code that already ran is not kept.
+	bc_program_clearMain(p);
+
+	s->fns = p->fns.len;
+	s->vars = p->vars.len;
+	s->arrs = p->arrs.len;
+
+	for (i = 0; i < BC_PROG_GLOBALS_LEN; ++i) s->globals[i] = p->globals[i];
+
+	bc_vec_init(&s->nums, sizeof(BcNum), bc_num_free);
+	bc_vec_init(&s->arrays, sizeof(BcVec), bc_vec_free);
+
+	for (i = 0; i < p->vars.len; ++i) {
+		BcNum n;
+		bc_num_createCopy(&n, bc_vec_top(bc_vec_item(&p->vars, i)));
+		bc_vec_push(&s->nums, &n);
+	}
+
+	for (i = 0; i < p->arrs.len; ++i) {
+		BcVec a;
+		bc_array_init(&a, true);
+		bc_array_copy(&a, bc_vec_top(bc_vec_item(&p->arrs, i)));
+		bc_vec_push(&s->arrays, &a);
+	}
+
+	bc_num_createCopy(&s->last, &p->last);
+
+#if BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
+	memcpy(&s->rng, bc_vec_top(&p->rng.v), sizeof(BcRNGData));
+#endif // BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
+}
+
+void bc_program_snapFree(BcProgramSnap *s) {
+
+	BC_SIG_ASSERT_LOCKED;
+
+	bc_vec_free(&s->nums);
+	bc_vec_free(&s->arrays);
+	bc_num_free(&s->last);
+}
+
+void bc_program_restore(BcProgram *p, const BcProgramSnap *s) {
+
+	size_t i;
+
+	BC_SIG_ASSERT_LOCKED;
+
+	assert(p->fns.len >= s->fns && p->vars.len >= s->vars &&
+	       p->arrs.len >= s->arrs);
+
+	bc_program_clearMain(p);
+
+	if (p->fns.len > s->fns) {
+
+		bc_vec_npop(&p->fns, p->fns.len - s->fns);
+		bc_map_truncate(&p->fn_map, s->fns);
+
+		// A later function could get the index of one that is gone.
+		bc_program_pureFlush(&p->pure);
+	}
+
+	bc_vec_npop(&p->vars, p->vars.len - s->vars);
+	bc_map_truncate(&p->var_map, s->vars);
+
+	bc_vec_npop(&p->arrs, p->arrs.len - s->arrs);
+	bc_map_truncate(&p->arr_map, s->arrs);
+
+	for (i = 0; i < p->vars.len; ++i) {
+		BcVec *v = bc_vec_item(&p->vars, i);
+		bc_vec_npop(v, v->len - 1);
+		bc_num_copy(bc_vec_top(v), bc_vec_item(&s->nums, i));
+	}
+
+	// Most arrays are empty, and stay that way, so they are not copied.
+	for (i = 0; i < p->arrs.len; ++i) {
+
+		BcVec *v = bc_vec_item(&p->arrs, i);
+		const BcVec *a = bc_vec_item(&s->arrays, i);
+
+		if (v->len > 1 || !bc_program_arrayEmpty(bc_vec_top(v)) ||
+		    !bc_program_arrayEmpty(a))
+		{
+			bc_vec_npop(v, v->len);
+			bc_array_expand(v, 1);
+			bc_array_copy(bc_vec_top(v), a);
+		}
+	}
+
+	for (i = 0; i < BC_PROG_GLOBALS_LEN; ++i) {
+		BcVec *v = p->globals_v + i;
+		bc_vec_npop(v, v->len - 1);
+		BC_PROG_GLOBAL(v) = p->globals[i] = s->globals[i];
+	}
+
+#if BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
+	bc_rand_pop(&p->rng, true);
+	memcpy(bc_vec_top(&p->rng.v), &s->rng, sizeof(BcRNGData));
+#endif // BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
+
+	bc_num_copy(&p->last, &s->last);
+}
+#endif // BC_ENABLED && !BC_ENABLE_LIBRARY
+
+#if BC_HAS_COMPUTED_GOTO
+
+#define BC_PROG_LBL(l) lbl_##l
+#define BC_PROG_LBL_ADDR(l) [l] = &&lbl_##l
+#define BC_PROG_FALLTHROUGH
+
+// When profiling, every instruction goes through the profiler first, and
+// otherwise, the profiler is not even checked.
+#if BC_PROG_PROFILE
+#define BC_PROG_LBLS lbls
+#else // BC_PROG_PROFILE
+#define BC_PROG_LBLS bc_program_inst_lbls
+#endif // BC_PROG_PROFILE
+
+// Every instruction dispatches the next one itself, which gives the branch
+// predictor one indirect jump per instruction instead of one shared by all.
+// The break leaves the loop in bc_program_exec() when the code runs out.
+#define BC_PROG_JUMP(inst, func, code, ip)                  \
+	BC_PROG_JUMP_ASSERT;                                    \
+	if (BC_NO_ERR((ip)->idx < (func)->code.len)) {          \
+		BC_SIG_ASSERT_NOT_LOCKED;                           \
+		(inst) = (uchar) (code)[((ip)->idx)++];             \
+		assert(bc_program_inst_lbls[(inst)] != NULL);       \
+		goto *BC_PROG_LBLS[(inst)];                         \
+	}                                                       \
+	break
+
+#else // BC_HAS_COMPUTED_GOTO
+
+#define BC_PROG_LBL(l) case l
+#define BC_PROG_FALLTHROUGH BC_FALLTHROUGH
+#define BC_PROG_JUMP(inst, func, code, ip) break
+
+#endif // BC_HAS_COMPUTED_GOTO
+
+#ifndef NDEBUG
+// This is to allow me to use a debugger to see the last instruction,
+// which will point to which function was the problem.
+#define BC_PROG_JUMP_ASSERT assert(jmp_bufs_len == vm.jmp_bufs.len)
+#else // NDEBUG
+#define BC_PROG_JUMP_ASSERT
+#endif // NDEBUG
+
 void bc_program_exec(BcProgram *p) {
 
 	size_t idx;
@@ -1814,38 +2701,205 @@ void bc_program_exec(BcProgram *p) {
 	BcFunc *func = (BcFunc*) bc_vec_item(&p->fns, ip->func);
 	char *code = func->code.v;
 	bool cond = false;
+	uchar inst;
 #if BC_ENABLED
 	BcNum *num;
 #endif // BC_ENABLED
 #ifndef NDEBUG
 	size_t jmp_bufs_len;
 #endif // NDEBUG
+#if BC_HAS_COMPUTED_GOTO
+	static const void* const bc_program_inst_lbls[] = {
+#if BC_ENABLED
+		BC_PROG_LBL_ADDR(BC_INST_INC),
+		BC_PROG_LBL_ADDR(BC_INST_DEC),
+#endif // BC_ENABLED
+		BC_PROG_LBL_ADDR(BC_INST_NEG),
+		BC_PROG_LBL_ADDR(BC_INST_BOOL_NOT),
+#if BC_ENABLE_EXTRA_MATH
+		BC_PROG_LBL_ADDR(BC_INST_TRUNC),
+#endif // BC_ENABLE_EXTRA_MATH
+		BC_PROG_LBL_ADDR(BC_INST_POWER),
+		BC_PROG_LBL_ADDR(BC_INST_MULTIPLY),
+		BC_PROG_LBL_ADDR(BC_INST_DIVIDE),
+		BC_PROG_LBL_ADDR(BC_INST_MODULUS),
+		BC_PROG_LBL_ADDR(BC_INST_PLUS),
+		BC_PROG_LBL_ADDR(BC_INST_MINUS),
+#if BC_ENABLE_EXTRA_MATH
+		BC_PROG_LBL_ADDR(BC_INST_PLACES),
+		BC_PROG_LBL_ADDR(BC_INST_LSHIFT),
+		BC_PROG_LBL_ADDR(BC_INST_RSHIFT),
+#endif // BC_ENABLE_EXTRA_MATH
+		BC_PROG_LBL_ADDR(BC_INST_REL_EQ),
+		BC_PROG_LBL_ADDR(BC_INST_REL_LE),
+		BC_PROG_LBL_ADDR(BC_INST_REL_GE),
+		BC_PROG_LBL_ADDR(BC_INST_REL_NE),
+		BC_PROG_LBL_ADDR(BC_INST_REL_LT),
+		BC_PROG_LBL_ADDR(BC_INST_REL_GT),
+		BC_PROG_LBL_ADDR(BC_INST_BOOL_OR),
+		BC_PROG_LBL_ADDR(BC_INST_BOOL_AND),
+#if BC_ENABLED
+		BC_PROG_LBL_ADDR(BC_INST_ASSIGN_POWER),
+		BC_PROG_LBL_ADDR(BC_INST_ASSIGN_MULTIPLY),
+		BC_PROG_LBL_ADDR(BC_INST_ASSIGN_DIVIDE),
+		BC_PROG_LBL_ADDR(BC_INST_ASSIGN_MODULUS),
+		BC_PROG_LBL_ADDR(BC_INST_ASSIGN_PLUS),
+		BC_PROG_LBL_ADDR(BC_INST_ASSIGN_MINUS),
+#if BC_ENABLE_EXTRA_MATH
+		BC_PROG_LBL_ADDR(BC_INST_ASSIGN_PLACES),
+		BC_PROG_LBL_ADDR(BC_INST_ASSIGN_LSHIFT),
+		BC_PROG_LBL_ADDR(BC_INST_ASSIGN_RSHIFT),
+#endif // BC_ENABLE_EXTRA_MATH
+		BC_PROG_LBL_ADDR(BC_INST_ASSIGN),
+		BC_PROG_LBL_ADDR(BC_INST_ASSIGN_POWER_NO_VAL),
+		BC_PROG_LBL_ADDR(BC_INST_ASSIGN_MULTIPLY_NO_VAL),
+		BC_PROG_LBL_ADDR(BC_INST_ASSIGN_DIVIDE_NO_VAL),
+		BC_PROG_LBL_ADDR(BC_INST_ASSIGN_MODULUS_NO_VAL),
+		BC_PROG_LBL_ADDR(BC_INST_ASSIGN_PLUS_NO_VAL),
+		BC_PROG_LBL_ADDR(BC_INST_ASSIGN_MINUS_NO_VAL),
+#if BC_ENABLE_EXTRA_MATH
+		BC_PROG_LBL_ADDR(BC_INST_ASSIGN_PLACES_NO_VAL),
+		BC_PROG_LBL_ADDR(BC_INST_ASSIGN_LSHIFT_NO_VAL),
+		BC_PROG_LBL_ADDR(BC_INST_ASSIGN_RSHIFT_NO_VAL),
+#endif // BC_ENABLE_EXTRA_MATH
+#endif // BC_ENABLED
+		BC_PROG_LBL_ADDR(BC_INST_ASSIGN_NO_VAL),
+		BC_PROG_LBL_ADDR(BC_INST_NUM),
+		BC_PROG_LBL_ADDR(BC_INST_VAR),
+		BC_PROG_LBL_ADDR(BC_INST_ARRAY_ELEM),
+#if BC_ENABLED
+		BC_PROG_LBL_ADDR(BC_INST_ARRAY),
+#endif // BC_ENABLED
+		BC_PROG_LBL_ADDR(BC_INST_ZERO),
+		BC_PROG_LBL_ADDR(BC_INST_ONE),
+#if BC_ENABLED
+		BC_PROG_LBL_ADDR(BC_INST_LAST),
+#endif // BC_ENABLED
+		BC_PROG_LBL_ADDR(BC_INST_IBASE),
+		BC_PROG_LBL_ADDR(BC_INST_OBASE),
+		BC_PROG_LBL_ADDR(BC_INST_SCALE),
+#if BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
+		BC_PROG_LBL_ADDR(BC_INST_SEED),
+#endif // BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
+		BC_PROG_LBL_ADDR(BC_INST_LENGTH),
+		BC_PROG_LBL_ADDR(BC_INST_SCALE_FUNC),
+		BC_PROG_LBL_ADDR(BC_INST_SQRT),
+		BC_PROG_LBL_ADDR(BC_INST_ABS),
+#if BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
+		BC_PROG_LBL_ADDR(BC_INST_IRAND),
+#endif // BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
+		BC_PROG_LBL_ADDR(BC_INST_READ),
+#if BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
+		BC_PROG_LBL_ADDR(BC_INST_RAND),
+#endif // BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
+		BC_PROG_LBL_ADDR(BC_INST_MAXIBASE),
+		BC_PROG_LBL_ADDR(BC_INST_MAXOBASE),
+		BC_PROG_LBL_ADDR(BC_INST_MAXSCALE),
+#if BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
+		BC_PROG_LBL_ADDR(BC_INST_MAXRAND),
+#endif // BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
+		BC_PROG_LBL_ADDR(BC_INST_PRINT),
+		BC_PROG_LBL_ADDR(BC_INST_PRINT_POP),
+		BC_PROG_LBL_ADDR(BC_INST_STR),
+		BC_PROG_LBL_ADDR(BC_INST_PRINT_STR),
+#if BC_ENABLED
+		BC_PROG_LBL_ADDR(BC_INST_JUMP),
+		BC_PROG_LBL_ADDR(BC_INST_JUMP_ZERO),
+		BC_PROG_LBL_ADDR(BC_INST_CALL),
+		BC_PROG_LBL_ADDR(BC_INST_CALL_CONST),
+		BC_PROG_LBL_ADDR(BC_INST_CALL_TAIL),
+		BC_PROG_LBL_ADDR(BC_INST_RET),
+		BC_PROG_LBL_ADDR(BC_INST_RET0),
+		BC_PROG_LBL_ADDR(BC_INST_RET_VOID),
+		BC_PROG_LBL_ADDR(BC_INST_HALT),
+		BC_PROG_LBL_ADDR(BC_INST_INC_VAR),
+		BC_PROG_LBL_ADDR(BC_INST_DEC_VAR),
+		BC_PROG_LBL_ADDR(BC_INST_ASSIGN_VAR),
+		BC_PROG_LBL_ADDR(BC_INST_JUMP_VAR_NUM),
+#endif // BC_ENABLED
+		BC_PROG_LBL_ADDR(BC_INST_POP),
+#if DC_ENABLED
+		BC_PROG_LBL_ADDR(BC_INST_POP_EXEC),
+		BC_PROG_LBL_ADDR(BC_INST_MODEXP),
+		BC_PROG_LBL_ADDR(BC_INST_DIVMOD),
+		BC_PROG_LBL_ADDR(BC_INST_EXECUTE),
+		BC_PROG_LBL_ADDR(BC_INST_EXEC_COND),
+		BC_PROG_LBL_ADDR(BC_INST_ASCIIFY),
+		BC_PROG_LBL_ADDR(BC_INST_PRINT_STREAM),
+		BC_PROG_LBL_ADDR(BC_INST_PRINT_STACK),
+		BC_PROG_LBL_ADDR(BC_INST_CLEAR_STACK),
+		BC_PROG_LBL_ADDR(BC_INST_STACK_LEN),
+		BC_PROG_LBL_ADDR(BC_INST_DUPLICATE),
+		BC_PROG_LBL_ADDR(BC_INST_SWAP),
+		BC_PROG_LBL_ADDR(BC_INST_LOAD),
+		BC_PROG_LBL_ADDR(BC_INST_PUSH_VAR),
+		BC_PROG_LBL_ADDR(BC_INST_PUSH_TO_VAR),
+		BC_PROG_LBL_ADDR(BC_INST_QUIT),
+		BC_PROG_LBL_ADDR(BC_INST_NQUIT),
+#endif // DC_ENABLED
+	};
+#if BC_PROG_PROFILE
+	static const void* bc_program_prof_lbls[UCHAR_MAX + 1];
+	const void* const *lbls = bc_program_inst_lbls;
+#endif // BC_PROG_PROFILE
+#endif // BC_HAS_COMPUTED_GOTO
 
 #ifndef NDEBUG
 	jmp_bufs_len = vm.jmp_bufs.len;
 #endif // NDEBUG
 
+#if BC_PROG_PROFILE
+	if (p->prof != NULL) {
+
+		// Whatever ran last was stopped by an error, and that time was not
+		// spent running it.
+		p->prof->running = false;
+
+#if BC_HAS_COMPUTED_GOTO
+		if (bc_program_prof_lbls[0] == NULL) {
+			for (idx = 0; idx <= UCHAR_MAX; ++idx)
+				bc_program_prof_lbls[idx] = &&lbl_prof;
+		}
+
+		lbls = bc_program_prof_lbls;
+#endif // BC_HAS_COMPUTED_GOTO
+	}
+#endif // BC_PROG_PROFILE
+
 	bc_program_setVecs(p, func);
 
 	while (ip->idx < func->code.len) {
 
 		BC_SIG_ASSERT_NOT_LOCKED;
 
-		uchar inst = (uchar) code[(ip->idx)++];
+		inst = (uchar) code[(ip->idx)++];
+
+#if BC_PROG_PROFILE
+		if (p->prof != NULL) {
+#if BC_HAS_COMPUTED_GOTO
+lbl_prof:
+#endif // BC_HAS_COMPUTED_GOTO
+			bc_program_profInst(p->prof, ip->func, inst);
+		}
+#endif // BC_PROG_PROFILE
 
+#if BC_HAS_COMPUTED_GOTO
+		goto *bc_program_inst_lbls[inst];
+#else // BC_HAS_COMPUTED_GOTO
 		switch (inst) {
+#endif // BC_HAS_COMPUTED_GOTO
 
 #if BC_ENABLED
-			case BC_INST_JUMP_ZERO:
+			BC_PROG_LBL(BC_INST_JUMP_ZERO):
 			{
 				bc_program_prep(p, &ptr, &num, 0);
 				cond = !bc_num_cmpZero(num);
 				bc_vec_pop(&p->results);
 			}
 			// Fallthrough.
-			BC_FALLTHROUGH
+			BC_PROG_FALLTHROUGH
 
-			case BC_INST_JUMP:
+			BC_PROG_LBL(BC_INST_JUMP):
 			{
 				idx = bc_program_index(code, &ip->idx);
 
@@ -1858,14 +2912,41 @@ void bc_program_exec(BcProgram *p) {
 					ip->idx = *addr;
 				}
 
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
+			}
+
+			BC_PROG_LBL(BC_INST_JUMP_VAR_NUM):
+			{
+				cond = !bc_program_relVarNum(p, code, &ip->idx);
+				idx = bc_program_index(code, &ip->idx);
+
+				if (cond) {
+
+					size_t *addr = bc_vec_item(&func->labels, idx);
+
+					assert(*addr != SIZE_MAX);
+
+					ip->idx = *addr;
+				}
+
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
-			case BC_INST_CALL:
+			BC_PROG_LBL(BC_INST_INC_VAR):
+			BC_PROG_LBL(BC_INST_DEC_VAR):
+			BC_PROG_LBL(BC_INST_ASSIGN_VAR):
+			{
+				bc_program_assignVar(p, code, &ip->idx, inst);
+				BC_PROG_JUMP(inst, func, code, ip);
+			}
+
+			BC_PROG_LBL(BC_INST_CALL):
+			BC_PROG_LBL(BC_INST_CALL_CONST):
+			BC_PROG_LBL(BC_INST_CALL_TAIL):
 			{
 				assert(BC_IS_BC);
 
-				bc_program_call(p, code, &ip->idx);
+				bc_program_call(p, code, &ip->idx, inst);
 
 				ip = bc_vec_top(&p->stack);
 				func = bc_vec_item(&p->fns, ip->func);
@@ -1873,26 +2954,26 @@ void bc_program_exec(BcProgram *p) {
 
 				bc_program_setVecs(p, func);
 
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
-			case BC_INST_INC:
-			case BC_INST_DEC:
+			BC_PROG_LBL(BC_INST_INC):
+			BC_PROG_LBL(BC_INST_DEC):
 			{
 				bc_program_incdec(p, inst);
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
-			case BC_INST_HALT:
+			BC_PROG_LBL(BC_INST_HALT):
 			{
 				vm.status = BC_STATUS_QUIT;
 				BC_VM_JMP;
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
-			case BC_INST_RET:
-			case BC_INST_RET0:
-			case BC_INST_RET_VOID:
+			BC_PROG_LBL(BC_INST_RET):
+			BC_PROG_LBL(BC_INST_RET0):
+			BC_PROG_LBL(BC_INST_RET_VOID):
 			{
 				bc_program_return(p, inst);
 
@@ -1902,24 +2983,24 @@ void bc_program_exec(BcProgram *p) {
 
 				bc_program_setVecs(p, func);
 
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 #endif // BC_ENABLED
 
-			case BC_INST_BOOL_OR:
-			case BC_INST_BOOL_AND:
-			case BC_INST_REL_EQ:
-			case BC_INST_REL_LE:
-			case BC_INST_REL_GE:
-			case BC_INST_REL_NE:
-			case BC_INST_REL_LT:
-			case BC_INST_REL_GT:
+			BC_PROG_LBL(BC_INST_BOOL_OR):
+			BC_PROG_LBL(BC_INST_BOOL_AND):
+			BC_PROG_LBL(BC_INST_REL_EQ):
+			BC_PROG_LBL(BC_INST_REL_LE):
+			BC_PROG_LBL(BC_INST_REL_GE):
+			BC_PROG_LBL(BC_INST_REL_NE):
+			BC_PROG_LBL(BC_INST_REL_LT):
+			BC_PROG_LBL(BC_INST_REL_GT):
 			{
 				bc_program_logical(p, inst);
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
-			case BC_INST_READ:
+			BC_PROG_LBL(BC_INST_READ):
 			{
 				bc_program_read(p);
 
@@ -1929,163 +3010,163 @@ void bc_program_exec(BcProgram *p) {
 
 				bc_program_setVecs(p, func);
 
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
 #if BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
-			case BC_INST_RAND:
+			BC_PROG_LBL(BC_INST_RAND):
 			{
 				bc_program_rand(p);
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 #endif // BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
 
-			case BC_INST_MAXIBASE:
-			case BC_INST_MAXOBASE:
-			case BC_INST_MAXSCALE:
+			BC_PROG_LBL(BC_INST_MAXIBASE):
+			BC_PROG_LBL(BC_INST_MAXOBASE):
+			BC_PROG_LBL(BC_INST_MAXSCALE):
 #if BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
-			case BC_INST_MAXRAND:
+			BC_PROG_LBL(BC_INST_MAXRAND):
 #endif // BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
 			{
 				BcBigDig dig = vm.maxes[inst - BC_INST_MAXIBASE];
 				bc_program_pushBigdig(p, dig, BC_RESULT_TEMP);
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
-			case BC_INST_VAR:
+			BC_PROG_LBL(BC_INST_VAR):
 			{
 				bc_program_pushVar(p, code, &ip->idx, false, false);
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
-			case BC_INST_ARRAY_ELEM:
+			BC_PROG_LBL(BC_INST_ARRAY_ELEM):
 #if BC_ENABLED
-			case BC_INST_ARRAY:
+			BC_PROG_LBL(BC_INST_ARRAY):
 #endif // BC_ENABLED
 			{
 				bc_program_pushArray(p, code, &ip->idx, inst);
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
-			case BC_INST_IBASE:
-			case BC_INST_SCALE:
-			case BC_INST_OBASE:
+			BC_PROG_LBL(BC_INST_IBASE):
+			BC_PROG_LBL(BC_INST_SCALE):
+			BC_PROG_LBL(BC_INST_OBASE):
 			{
 				bc_program_pushGlobal(p, inst);
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
 #if BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
-			case BC_INST_SEED:
+			BC_PROG_LBL(BC_INST_SEED):
 			{
 				bc_program_pushSeed(p);
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 #endif // BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
 
-			case BC_INST_LENGTH:
-			case BC_INST_SCALE_FUNC:
-			case BC_INST_SQRT:
-			case BC_INST_ABS:
+			BC_PROG_LBL(BC_INST_LENGTH):
+			BC_PROG_LBL(BC_INST_SCALE_FUNC):
+			BC_PROG_LBL(BC_INST_SQRT):
+			BC_PROG_LBL(BC_INST_ABS):
 #if BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
-			case BC_INST_IRAND:
+			BC_PROG_LBL(BC_INST_IRAND):
 #endif // BC_ENABLE_EXTRA_MATH && BC_ENABLE_RAND
 			{
 				bc_program_builtin(p, inst);
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
-			case BC_INST_NUM:
+			BC_PROG_LBL(BC_INST_NUM):
 			{
 				bc_program_const(p, code, &ip->idx);
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
-			case BC_INST_ZERO:
-			case BC_INST_ONE:
+			BC_PROG_LBL(BC_INST_ZERO):
+			BC_PROG_LBL(BC_INST_ONE):
 #if BC_ENABLED
-			case BC_INST_LAST:
+			BC_PROG_LBL(BC_INST_LAST):
 #endif // BC_ENABLED
 			{
 				r.t = BC_RESULT_ZERO + (inst - BC_INST_ZERO);
 				bc_vec_push(&p->results, &r);
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
-			case BC_INST_PRINT:
-			case BC_INST_PRINT_POP:
-			case BC_INST_PRINT_STR:
+			BC_PROG_LBL(BC_INST_PRINT):
+			BC_PROG_LBL(BC_INST_PRINT_POP):
+			BC_PROG_LBL(BC_INST_PRINT_STR):
 			{
 				bc_program_print(p, inst, 0);
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
-			case BC_INST_STR:
+			BC_PROG_LBL(BC_INST_STR):
 			{
 				r.t = BC_RESULT_STR;
 				r.d.loc.loc = bc_program_index(code, &ip->idx);
 				bc_vec_push(&p->results, &r);
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
-			case BC_INST_POWER:
-			case BC_INST_MULTIPLY:
-			case BC_INST_DIVIDE:
-			case BC_INST_MODULUS:
-			case BC_INST_PLUS:
-			case BC_INST_MINUS:
+			BC_PROG_LBL(BC_INST_POWER):
+			BC_PROG_LBL(BC_INST_MULTIPLY):
+			BC_PROG_LBL(BC_INST_DIVIDE):
+			BC_PROG_LBL(BC_INST_MODULUS):
+			BC_PROG_LBL(BC_INST_PLUS):
+			BC_PROG_LBL(BC_INST_MINUS):
 #if BC_ENABLE_EXTRA_MATH
-			case BC_INST_PLACES:
-			case BC_INST_LSHIFT:
-			case BC_INST_RSHIFT:
+			BC_PROG_LBL(BC_INST_PLACES):
+			BC_PROG_LBL(BC_INST_LSHIFT):
+			BC_PROG_LBL(BC_INST_RSHIFT):
 #endif // BC_ENABLE_EXTRA_MATH
 			{
 				bc_program_op(p, inst);
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
-			case BC_INST_NEG:
-			case BC_INST_BOOL_NOT:
+			BC_PROG_LBL(BC_INST_NEG):
+			BC_PROG_LBL(BC_INST_BOOL_NOT):
 #if BC_ENABLE_EXTRA_MATH
-			case BC_INST_TRUNC:
+			BC_PROG_LBL(BC_INST_TRUNC):
 #endif // BC_ENABLE_EXTRA_MATH
 			{
 				bc_program_unary(p, inst);
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
 #if BC_ENABLED
-			case BC_INST_ASSIGN_POWER:
-			case BC_INST_ASSIGN_MULTIPLY:
-			case BC_INST_ASSIGN_DIVIDE:
-			case BC_INST_ASSIGN_MODULUS:
-			case BC_INST_ASSIGN_PLUS:
-			case BC_INST_ASSIGN_MINUS:
+			BC_PROG_LBL(BC_INST_ASSIGN_POWER):
+			BC_PROG_LBL(BC_INST_ASSIGN_MULTIPLY):
+			BC_PROG_LBL(BC_INST_ASSIGN_DIVIDE):
+			BC_PROG_LBL(BC_INST_ASSIGN_MODULUS):
+			BC_PROG_LBL(BC_INST_ASSIGN_PLUS):
+			BC_PROG_LBL(BC_INST_ASSIGN_MINUS):
 #if BC_ENABLE_EXTRA_MATH
-			case BC_INST_ASSIGN_PLACES:
-			case BC_INST_ASSIGN_LSHIFT:
-			case BC_INST_ASSIGN_RSHIFT:
+			BC_PROG_LBL(BC_INST_ASSIGN_PLACES):
+			BC_PROG_LBL(BC_INST_ASSIGN_LSHIFT):
+			BC_PROG_LBL(BC_INST_ASSIGN_RSHIFT):
 #endif // BC_ENABLE_EXTRA_MATH
-			case BC_INST_ASSIGN:
-			case BC_INST_ASSIGN_POWER_NO_VAL:
-			case BC_INST_ASSIGN_MULTIPLY_NO_VAL:
-			case BC_INST_ASSIGN_DIVIDE_NO_VAL:
-			case BC_INST_ASSIGN_MODULUS_NO_VAL:
-			case BC_INST_ASSIGN_PLUS_NO_VAL:
-			case BC_INST_ASSIGN_MINUS_NO_VAL:
+			BC_PROG_LBL(BC_INST_ASSIGN):
+			BC_PROG_LBL(BC_INST_ASSIGN_POWER_NO_VAL):
+			BC_PROG_LBL(BC_INST_ASSIGN_MULTIPLY_NO_VAL):
+			BC_PROG_LBL(BC_INST_ASSIGN_DIVIDE_NO_VAL):
+			BC_PROG_LBL(BC_INST_ASSIGN_MODULUS_NO_VAL):
+			BC_PROG_LBL(BC_INST_ASSIGN_PLUS_NO_VAL):
+			BC_PROG_LBL(BC_INST_ASSIGN_MINUS_NO_VAL):
 #if BC_ENABLE_EXTRA_MATH
-			case BC_INST_ASSIGN_PLACES_NO_VAL:
-			case BC_INST_ASSIGN_LSHIFT_NO_VAL:
-			case BC_INST_ASSIGN_RSHIFT_NO_VAL:
+			BC_PROG_LBL(BC_INST_ASSIGN_PLACES_NO_VAL):
+			BC_PROG_LBL(BC_INST_ASSIGN_LSHIFT_NO_VAL):
+			BC_PROG_LBL(BC_INST_ASSIGN_RSHIFT_NO_VAL):
 #endif // BC_ENABLE_EXTRA_MATH
 #endif // BC_ENABLED
-			case BC_INST_ASSIGN_NO_VAL:
+			BC_PROG_LBL(BC_INST_ASSIGN_NO_VAL):
 			{
 				bc_program_assign(p, inst);
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
-			case BC_INST_POP:
+			BC_PROG_LBL(BC_INST_POP):
 			{
 #ifndef BC_PROG_NO_STACK_CHECK
 				if (!BC_IS_BC) {
@@ -2097,11 +3178,11 @@ void bc_program_exec(BcProgram *p) {
 				assert(BC_PROG_STACK(&p->results, 1));
 
 				bc_vec_pop(&p->results);
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
 #if DC_ENABLED
-			case BC_INST_POP_EXEC:
+			BC_PROG_LBL(BC_INST_POP_EXEC):
 			{
 				assert(BC_PROG_STACK(&p->stack, 2));
 				bc_vec_pop(&p->stack);
@@ -2110,23 +3191,23 @@ void bc_program_exec(BcProgram *p) {
 				func = bc_vec_item(&p->fns, ip->func);
 				code = func->code.v;
 				bc_program_setVecs(p, func);
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
-			case BC_INST_MODEXP:
+			BC_PROG_LBL(BC_INST_MODEXP):
 			{
 				bc_program_modexp(p);
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
-			case BC_INST_DIVMOD:
+			BC_PROG_LBL(BC_INST_DIVMOD):
 			{
 				bc_program_divmod(p);
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
-			case BC_INST_EXECUTE:
-			case BC_INST_EXEC_COND:
+			BC_PROG_LBL(BC_INST_EXECUTE):
+			BC_PROG_LBL(BC_INST_EXEC_COND):
 			{
 				cond = (inst == BC_INST_EXEC_COND);
 				bc_program_execStr(p, code, &ip->idx, cond, func->code.len);
@@ -2134,28 +3215,28 @@ void bc_program_exec(BcProgram *p) {
 				func = bc_vec_item(&p->fns, ip->func);
 				code = func->code.v;
 				bc_program_setVecs(p, func);
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
-			case BC_INST_PRINT_STACK:
+			BC_PROG_LBL(BC_INST_PRINT_STACK):
 			{
 				bc_program_printStack(p);
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
-			case BC_INST_CLEAR_STACK:
+			BC_PROG_LBL(BC_INST_CLEAR_STACK):
 			{
 				bc_vec_npop(&p->results, p->results.len);
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
-			case BC_INST_STACK_LEN:
+			BC_PROG_LBL(BC_INST_STACK_LEN):
 			{
 				bc_program_stackLen(p);
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
-			case BC_INST_DUPLICATE:
+			BC_PROG_LBL(BC_INST_DUPLICATE):
 			{
 				if (BC_ERR(!BC_PROG_STACK(&p->results, 1)))
 					bc_vm_err(BC_ERR_EXEC_STACK);
@@ -2171,10 +3252,10 @@ void bc_program_exec(BcProgram *p) {
 
 				BC_SIG_UNLOCK;
 
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
-			case BC_INST_SWAP:
+			BC_PROG_LBL(BC_INST_SWAP):
 			{
 				BcResult *ptr2;
 
@@ -2189,51 +3270,52 @@ void bc_program_exec(BcProgram *p) {
 				memcpy(ptr, ptr2, sizeof(BcResult));
 				memcpy(ptr2, &r, sizeof(BcResult));
 
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
-			case BC_INST_ASCIIFY:
+			BC_PROG_LBL(BC_INST_ASCIIFY):
 			{
 				bc_program_asciify(p);
 				ip = bc_vec_top(&p->stack);
 				func = bc_vec_item(&p->fns, ip->func);
 				code = func->code.v;
 				bc_program_setVecs(p, func);
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
-			case BC_INST_PRINT_STREAM:
+			BC_PROG_LBL(BC_INST_PRINT_STREAM):
 			{
 				bc_program_printStream(p);
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
-			case BC_INST_LOAD:
-			case BC_INST_PUSH_VAR:
+			BC_PROG_LBL(BC_INST_LOAD):
+			BC_PROG_LBL(BC_INST_PUSH_VAR):
 			{
 				bool copy = (inst == BC_INST_LOAD);
 				bc_program_pushVar(p, code, &ip->idx, true, copy);
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
-			case BC_INST_PUSH_TO_VAR:
+			BC_PROG_LBL(BC_INST_PUSH_TO_VAR):
 			{
 				idx = bc_program_index(code, &ip->idx);
 				bc_program_copyToVar(p, idx, BC_TYPE_VAR, true);
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 
-			case BC_INST_QUIT:
-			case BC_INST_NQUIT:
+			BC_PROG_LBL(BC_INST_QUIT):
+			BC_PROG_LBL(BC_INST_NQUIT):
 			{
 				bc_program_nquit(p, inst);
 				ip = bc_vec_top(&p->stack);
 				func = bc_vec_item(&p->fns, ip->func);
 				code = func->code.v;
 				bc_program_setVecs(p, func);
-				break;
+				BC_PROG_JUMP(inst, func, code, ip);
 			}
 #endif // DC_ENABLED
+#if !BC_HAS_COMPUTED_GOTO
 #ifndef NDEBUG
 			default:
 			{
@@ -2242,13 +3324,266 @@ void bc_program_exec(BcProgram *p) {
 #endif // NDEBUG
 		}
 
-#ifndef NDEBUG
-		// This is to allow me to use a debugger to see the last instruction,
-		// which will point to which function was the problem.
-		assert(jmp_bufs_len == vm.jmp_bufs.len);
-#endif // NDEBUG
+		BC_PROG_JUMP_ASSERT;
+#endif // !BC_HAS_COMPUTED_GOTO
+	}
+
+#if BC_PROG_PROFILE
+	if (p->prof != NULL) bc_program_profStop(p->prof);
+#endif // BC_PROG_PROFILE
+}
+
+#if BC_PROG_PROFILE
+void bc_program_profile(BcProgram *p, BcProfFmt fmt) {
+
+	BC_SIG_ASSERT_LOCKED;
+
+	if (p->prof == NULL) {
+		p->prof = bc_vm_malloc(sizeof(BcProf));
+		memset(p->prof, 0, sizeof(BcProf));
+		bc_vec_init(&p->prof->fns, sizeof(BcProfFunc), NULL);
+	}
+
+	p->prof->fmt = fmt;
+}
+
+static int bc_program_profInstCmp(const void *a, const void *b) {
+	const BcProfInst *i1 = *((const BcProfInst* const*) a);
+	const BcProfInst *i2 = *((const BcProfInst* const*) b);
+	return (i1->ticks < i2->ticks) - (i1->ticks > i2->ticks);
+}
+
+static int bc_program_profFuncCmp(const void *a, const void *b) {
+	const BcProfFunc *f1 = *((const BcProfFunc* const*) a);
+	const BcProfFunc *f2 = *((const BcProfFunc* const*) b);
+	return (f1->ticks < f2->ticks) - (f1->ticks > f2->ticks);
+}
+
+// Prints a number right-aligned in a column.
+static void bc_program_profCol(uint64_t val, size_t width) {
+
+	uint64_t n;
+	size_t len = 1;
+
+	for (n = val; n >= 10; n /= 10) len += 1;
+	for (; len < width; ++len) bc_file_putchar(&vm.ferr, ' ');
+
+	bc_file_printf(&vm.ferr, "%llu", (unsigned long long) val);
+}
+
+// dc functions are named by their strings, which can have anything in them.
+static void bc_program_profName(const char *name, BcProfFmt fmt) {
+
+	static const char hex[] = "0123456789abcdef";
+	uchar c;
+
+	if (fmt == BC_PROF_TEXT) {
+		for (; (c = (uchar) *name); ++name)
+			bc_file_putchar(&vm.ferr, isprint(c) ? c : '?');
+		return;
+	}
+
+	bc_file_putchar(&vm.ferr, '"');
+
+	for (; (c = (uchar) *name); ++name) {
+
+		if (fmt == BC_PROF_CSV) {
+			if (c == '"') bc_file_putchar(&vm.ferr, '"');
+			bc_file_putchar(&vm.ferr, c);
+		}
+		else if (c == '"' || c == '\\') {
+			bc_file_putchar(&vm.ferr, '\\');
+			bc_file_putchar(&vm.ferr, c);
+		}
+		else if (c < ' ') {
+			bc_file_puts(&vm.ferr, "\\u00");
+			bc_file_putchar(&vm.ferr, (uchar) hex[c >> 4]);
+			bc_file_putchar(&vm.ferr, (uchar) hex[c & 0xf]);
+		}
+		else bc_file_putchar(&vm.ferr, c);
 	}
+
+	bc_file_putchar(&vm.ferr, '"');
+}
+
+static void bc_program_profInstLine(BcProf *prof, BcProfInst *i,
+                                    uint64_t total, bool first)
+{
+	const char *name = bc_inst_names[i - prof->insts] + strlen("BC_INST_");
+	uint64_t digs = 0, max = (uint64_t) i->max * BC_BASE_DIGS;
+	uint64_t pct = total ? i->ticks * 1000 / total : 0;
+
+	if (i->nums) digs = i->limbs * BC_BASE_DIGS / i->nums;
+
+	if (prof->fmt == BC_PROF_JSON) {
+		bc_file_printf(&vm.ferr, "%s\n    {\"name\": \"%s\", \"count\": %llu, "
+		               "\"ticks\": %llu", first ? "" : ",", name,
+		               (unsigned long long) i->count,
+		               (unsigned long long) i->ticks);
+		if (i->nums) {
+			bc_file_printf(&vm.ferr, ", \"digits\": %llu, \"max_digits\": "
+			               "%llu", (unsigned long long) digs,
+			               (unsigned long long) max);
+		}
+		bc_file_putchar(&vm.ferr, '}');
+	}
+	else if (prof->fmt == BC_PROF_CSV) {
+		bc_file_printf(&vm.ferr, "instruction,%s,%llu,,%llu,", name,
+		               (unsigned long long) i->count,
+		               (unsigned long long) i->ticks);
+		if (i->nums) {
+			bc_file_printf(&vm.ferr, "%llu,%llu", (unsigned long long) digs,
+			               (unsigned long long) max);
+		}
+		else bc_file_putchar(&vm.ferr, ',');
+		bc_file_putchar(&vm.ferr, '\n');
+	}
+	else {
+		bc_program_profCol(i->ticks, 14);
+		bc_program_profCol(pct / 10, 5);
+		bc_file_printf(&vm.ferr, ".%llu", (unsigned long long) (pct % 10));
+		bc_program_profCol(i->count, 12);
+		if (i->nums) {
+			bc_program_profCol(digs, 12);
+			bc_program_profCol(max, 12);
+		}
+		else bc_file_puts(&vm.ferr, "                        ");
+		bc_file_printf(&vm.ferr, "  %s\n", name);
+	}
+}
+
+static void bc_program_profFuncLine(BcProgram *p, BcProfFunc *f,
+                                    uint64_t total, bool first)
+{
+	BcProf *prof = p->prof;
+	size_t idx = (size_t) (f - (BcProfFunc*) prof->fns.v);
+	const char *name = ((BcFunc*) bc_vec_item(&p->fns, idx))->name;
+	uint64_t pct = total ? f->ticks * 1000 / total : 0;
+
+	if (prof->fmt == BC_PROF_JSON) {
+		bc_file_printf(&vm.ferr, "%s\n    {\"name\": ", first ? "" : ",");
+		bc_program_profName(name, prof->fmt);
+		bc_file_printf(&vm.ferr, ", \"index\": %zu, \"calls\": %llu, "
+		               "\"count\": %llu, \"ticks\": %llu}", idx,
+		               (unsigned long long) f->calls,
+		               (unsigned long long) f->insts,
+		               (unsigned long long) f->ticks);
+	}
+	else if (prof->fmt == BC_PROF_CSV) {
+		bc_file_puts(&vm.ferr, "function,");
+		bc_program_profName(name, prof->fmt);
+		bc_file_printf(&vm.ferr, ",%llu,%llu,%llu,,\n",
+		               (unsigned long long) f->insts,
+		               (unsigned long long) f->calls,
+		               (unsigned long long) f->ticks);
+	}
+	else {
+		bc_program_profCol(f->ticks, 14);
+		bc_program_profCol(pct / 10, 5);
+		bc_file_printf(&vm.ferr, ".%llu", (unsigned long long) (pct % 10));
+		bc_program_profCol(f->insts, 12);
+		bc_program_profCol(f->calls, 12);
+		bc_file_puts(&vm.ferr, "  ");
+		bc_program_profName(name, prof->fmt);
+		bc_file_putchar(&vm.ferr, '\n');
+	}
+}
+
+#if BC_ENABLED
+static void bc_program_profPure(BcProgram *p) {
+
+	BcPure *c = &p->pure;
+	BcProfFmt fmt = p->prof->fmt;
+
+	if (fmt == BC_PROF_JSON) {
+		bc_file_printf(&vm.ferr, ",\n  \"pure\": {\"hits\": %zu, "
+		               "\"misses\": %zu, \"cached\": %zu, \"flushes\": %zu}",
+		               c->hits, c->misses, c->used, c->flushes);
+	}
+	else if (fmt == BC_PROF_CSV) {
+		bc_file_printf(&vm.ferr, "pure,hits,%zu,,,,\npure,misses,%zu,,,,\n"
+		               "pure,cached,%zu,,,,\npure,flushes,%zu,,,,\n", c->hits,
+		               c->misses, c->used, c->flushes);
+	}
+	else {
+		bc_file_printf(&vm.ferr, "\npure: %zu hits, %zu misses, %zu cached, "
+		               "%zu flushes\n", c->hits, c->misses, c->used, c->flushes);
+	}
+}
+#endif // BC_ENABLED
+
+void bc_program_report(BcProgram *p) {
+
+	BcProf *prof = p->prof;
+	BcProfInst *insts[UCHAR_MAX + 1];
+	BcProfFunc **fns;
+	size_t i, ninsts = 0, nfns = 0;
+	uint64_t total = 0;
+
+	BC_SIG_ASSERT_LOCKED;
+
+	assert(prof != NULL);
+
+	// Functions can be removed when bc recovers from an error or a server
+	// request ends, and then their numbers mean nothing.
+	if (prof->fns.len > p->fns.len)
+		bc_vec_npop(&prof->fns, prof->fns.len - p->fns.len);
+
+	fns = bc_vm_malloc(bc_vm_arraySize(prof->fns.len + 1, sizeof(BcProfFunc*)));
+
+	for (i = 0; i <= UCHAR_MAX; ++i) {
+		if (!prof->insts[i].count) continue;
+		insts[ninsts++] = prof->insts + i;
+		total += prof->insts[i].ticks;
+	}
+
+	for (i = 0; i < prof->fns.len; ++i) {
+		BcProfFunc *f = bc_vec_item(&prof->fns, i);
+		if (f->insts || f->calls) fns[nfns++] = f;
+	}
+
+	qsort(insts, ninsts, sizeof(BcProfInst*), bc_program_profInstCmp);
+	qsort(fns, nfns, sizeof(BcProfFunc*), bc_program_profFuncCmp);
+
+	if (prof->fmt == BC_PROF_JSON) {
+		bc_file_printf(&vm.ferr, "{\n  \"unit\": \"%s\",\n  \"ticks\": %llu,\n"
+		               "  \"instructions\": [", BC_PROG_TICKS,
+		               (unsigned long long) total);
+	}
+	else if (prof->fmt == BC_PROF_CSV)
+		bc_file_puts(&vm.ferr, "kind,name,count,calls,ticks,digits,max_digits\n");
+	else {
+		bc_file_printf(&vm.ferr, "profile: %llu %s\n\n",
+		               (unsigned long long) total, BC_PROG_TICKS);
+		bc_file_puts(&vm.ferr, "         ticks      %       count  "
+		             "avg digits  max digits  instruction\n");
+	}
+
+	for (i = 0; i < ninsts; ++i)
+		bc_program_profInstLine(prof, insts[i], total, !i);
+
+	if (prof->fmt == BC_PROF_JSON)
+		bc_file_puts(&vm.ferr, "\n  ],\n  \"functions\": [");
+	else if (prof->fmt == BC_PROF_TEXT) {
+		bc_file_puts(&vm.ferr, "\n         ticks      %       count       "
+		             "calls  function\n");
+	}
+
+	for (i = 0; i < nfns; ++i) bc_program_profFuncLine(p, fns[i], total, !i);
+
+	if (prof->fmt == BC_PROF_JSON) bc_file_puts(&vm.ferr, "\n  ]");
+
+#if BC_ENABLED
+	if (BC_IS_BC) bc_program_profPure(p);
+#endif // BC_ENABLED
+
+	if (prof->fmt == BC_PROF_JSON) bc_file_puts(&vm.ferr, "\n}\n");
+
+	bc_file_flush(&vm.ferr);
+
+	free(fns);
 }
+#endif // BC_PROG_PROFILE
 
 #if BC_DEBUG_CODE
 #if BC_ENABLED && DC_ENABLED
@@ -2261,15 +3596,7 @@ void bc_program_printStackDebug(BcProgram *p) {
 static void bc_program_printIndex(const char *restrict code,
                                   size_t *restrict bgn)
 {
-	uchar byte, i, bytes = (uchar) code[(*bgn)++];
-	ulong val = 0;
-
-	for (byte = 1, i = 0; byte && i < bytes; ++i) {
-		byte = (uchar) code[(*bgn)++];
-		if (byte) val |= ((ulong) byte) << (CHAR_BIT * i);
-	}
-
-	bc_vm_printf(" (%lu) ", val);
+	bc_vm_printf(" (%zu) ", bc_program_index(code, bgn));
 }
 
 static void bc_program_printStr(const BcProgram *p, const char *restrict code,
@@ -2300,13 +3627,25 @@ void bc_program_printInst(const BcProgram *p, const char *restrict code,
 	else if (inst == BC_INST_NUM) {
 		size_t idx = bc_program_index(code, bgn);
 		BcConst *c = bc_vec_item(p->consts, idx);
-		bc_vm_printf("(%s)", c->val);
+		if (c->fold) bc_vm_printf("(folded)");
+		else bc_vm_printf("(%s)", c->val);
+	}
+	else if (inst >= BC_INST_INC_VAR && inst <= BC_INST_JUMP_VAR_NUM) {
+
+		if (inst >= BC_INST_ASSIGN_VAR)
+			bc_vm_printf("%s", bc_inst_names[(uchar) code[(*bgn)++]]);
+
+		bc_program_printIndex(code, bgn);
+
+		if (inst >= BC_INST_ASSIGN_VAR) bc_program_printIndex(code, bgn);
+		if (inst == BC_INST_JUMP_VAR_NUM) bc_program_printIndex(code, bgn);
 	}
-	else if (inst == BC_INST_CALL ||
+	else if (inst == BC_INST_CALL || inst == BC_INST_CALL_CONST ||
+	         inst == BC_INST_CALL_TAIL ||
 	         (inst > BC_INST_STR && inst <= BC_INST_JUMP_ZERO))
 	{
 		bc_program_printIndex(code, bgn);
-		if (inst == BC_INST_CALL) bc_program_printIndex(code, bgn);
+		if (inst >= BC_INST_CALL) bc_program_printIndex(code, bgn);
 	}
 
 	bc_vm_putchar('\n');
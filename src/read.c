@@ -45,12 +45,16 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif // _WIN32
+
 #include <read.h>
 #include <history.h>
 #include <program.h>
 #include <vm.h>
 
-static bool bc_read_binary(const char *buf, size_t size) {
+bool bc_read_binary(const char *buf, size_t size) {
 
 	size_t i;
 
@@ -105,6 +109,22 @@ BcStatus bc_read_chars(BcVec *vec, const char *prompt) {
 	}
 #endif // BC_ENABLE_PROMPT
 
+	// The block reader in bc_vm_stdin() may already have the next lines.
+	if (vm.stdin_len) {
+
+		const char *nl = memchr(vm.stdin_buf, '\n', vm.stdin_len);
+		size_t n = nl != NULL ? (size_t) (nl + 1 - vm.stdin_buf) : vm.stdin_len;
+
+		bc_vec_npush(vec, n, vm.stdin_buf);
+		vm.stdin_buf += n;
+		vm.stdin_len -= n;
+
+		if (nl != NULL) {
+			bc_vec_pushByte(vec, '\0');
+			return BC_STATUS_SUCCESS;
+		}
+	}
+
 	if (bc_read_buf(vec, vm.buf, &vm.buf_len)) {
 		bc_vec_pushByte(vec, '\0');
 		return BC_STATUS_SUCCESS;
@@ -225,3 +245,55 @@ malloc_err:
 	close(fd);
 	bc_vm_verr(e, path);
 }
+
+#ifndef _WIN32
+char* bc_read_map(const char *path, size_t *len) {
+
+	struct stat pstat;
+	size_t page = (size_t) sysconf(_SC_PAGESIZE);
+	void *map;
+	int fd;
+
+	BC_SIG_ASSERT_LOCKED;
+
+	assert(path != NULL);
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) return NULL;
+
+	// The NUL that ends the text goes in the rest of the last page, so a file
+	// that fills the page is read instead.
+	if (fstat(fd, &pstat) == -1 || !S_ISREG(pstat.st_mode) ||
+	    !((size_t) pstat.st_size % page))
+	{
+		close(fd);
+		return NULL;
+	}
+
+	*len = (size_t) pstat.st_size;
+	map = mmap(NULL, *len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+	// A file that changed size before it was mapped is read instead, since
+	// the text would not end at the NUL.
+	if (map != MAP_FAILED &&
+	    (fstat(fd, &pstat) == -1 || (size_t) pstat.st_size != *len))
+	{
+		munmap(map, *len);
+		map = MAP_FAILED;
+	}
+
+	close(fd);
+
+	if (map == MAP_FAILED) return NULL;
+
+	// Writing the NUL makes the last page a private copy, so the text still
+	// ends there if the file grows. A file that is cut short while it is
+	// mapped is not handled: bc gets SIGBUS if it reaches a page that is past
+	// the new end, like any program reading a mapped file that is truncated.
+	((char*) map)[*len] = '\0';
+
+	posix_madvise(map, *len, POSIX_MADV_SEQUENTIAL);
+
+	return map;
+}
+#endif // _WIN32
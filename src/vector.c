@@ -48,6 +48,9 @@ void bc_vec_grow(BcVec *restrict v, size_t n) {
 
 	len = bc_vm_growSize(v->len, n);
 
+	// A lazy vector has no capacity at all until it is first grown.
+	if (!cap) cap = BC_VEC_START_CAP;
+
 	while (cap < len) cap = bc_vm_growSize(cap, cap);
 
 	BC_SIG_TRYLOCK(lock);
@@ -66,6 +69,18 @@ void bc_vec_init(BcVec *restrict v, size_t esize, BcVecFree dtor) {
 	v->v = bc_vm_malloc(bc_vm_arraySize(BC_VEC_START_CAP, esize));
 }
 
+// This is for the many vectors that are never used, like the constants of
+// functions without any, so they cost nothing until they are.
+void bc_vec_initLazy(BcVec *restrict v, size_t esize, BcVecFree dtor) {
+	BC_SIG_ASSERT_LOCKED;
+	assert(v != NULL && esize);
+	v->size = esize;
+	v->cap = 0;
+	v->len = 0;
+	v->dtor = dtor;
+	v->v = NULL;
+}
+
 void bc_vec_expand(BcVec *restrict v, size_t req) {
 
 	assert(v != NULL);
@@ -103,6 +118,7 @@ void bc_vec_npop(BcVec *restrict v, size_t n) {
 void bc_vec_npopAt(BcVec *restrict v, size_t n, size_t idx) {
 
 	char* ptr, *data;
+	sig_atomic_t lock;
 
 	assert(v != NULL);
 	assert(idx + n < v->len);
@@ -110,7 +126,7 @@ void bc_vec_npopAt(BcVec *restrict v, size_t n, size_t idx) {
 	ptr = bc_vec_item(v, idx);
 	data = bc_vec_item(v, idx + n);
 
-	BC_SIG_LOCK;
+	BC_SIG_TRYLOCK(lock);
 
 	if (v->dtor != NULL) {
 
@@ -122,7 +138,7 @@ void bc_vec_npopAt(BcVec *restrict v, size_t n, size_t idx) {
 	v->len -= n;
 	memmove(ptr, data, (v->len - idx) * v->size);
 
-	BC_SIG_UNLOCK;
+	BC_SIG_TRYUNLOCK(lock);
 }
 
 void bc_vec_npush(BcVec *restrict v, size_t n, const void *data) {
@@ -152,44 +168,12 @@ void bc_vec_pushByte(BcVec *restrict v, uchar data) {
 
 void bc_vec_pushIndex(BcVec *restrict v, size_t idx) {
 
-	uchar amt, nums[sizeof(size_t) + 1];
-
 	assert(v != NULL);
 	assert(v->size == sizeof(uchar));
 
-	for (amt = 0; idx; ++amt) {
-		nums[amt + 1] = (uchar) idx;
-		idx &= ((size_t) ~(UCHAR_MAX));
-		idx >>= sizeof(uchar) * CHAR_BIT;
-	}
-
-	nums[0] = amt;
-
-	bc_vec_npush(v, amt + 1, nums);
-}
-
-static void bc_vec_pushAt(BcVec *restrict v, const void *data, size_t idx) {
-
-	sig_atomic_t lock;
-
-	assert(v != NULL && data != NULL && idx <= v->len);
-
-	BC_SIG_TRYLOCK(lock);
-
-	if (idx == v->len) bc_vec_push(v, data);
-	else {
-
-		char *ptr;
-
-		if (v->len == v->cap) bc_vec_grow(v, 1);
-
-		ptr = v->v + v->size * idx;
-
-		memmove(ptr + v->size, ptr, v->size * (v->len++ - idx));
-		memmove(ptr, data, v->size);
-	}
-
-	BC_SIG_TRYUNLOCK(lock);
+	// Indices are stored at their full, native width so that the interpreter
+	// can read one with a single load instead of decoding it byte by byte.
+	bc_vec_npush(v, BC_VEC_INDEX_SIZE, &idx);
 }
 
 void bc_vec_string(BcVec *restrict v, size_t len, const char *restrict str) {
@@ -287,58 +271,177 @@ void bc_vec_free(void *vec) {
 	free(v->v);
 }
 
-static size_t bc_map_find(const BcVec *restrict v, const char *name) {
+void bc_map_init(BcMap *restrict m) {
+
+	BC_SIG_ASSERT_LOCKED;
+
+	assert(m != NULL);
 
-	size_t low = 0, high = v->len;
+#ifndef NDEBUG
+	bc_vec_init(&m->ids, sizeof(BcId), bc_id_free);
+#else // NDEBUG
+	bc_vec_init(&m->ids, sizeof(BcId), NULL);
+#endif // NDEBUG
 
-	while (low < high) {
+	// The table is allocated by the first insert.
+	m->slots = NULL;
+	m->cap = 0;
+}
 
-		size_t mid = (low + high) / 2;
-		const BcId *id = bc_vec_item(v, mid);
-		int result = strcmp(name, id->name);
+#ifndef NDEBUG
+void bc_map_free(void *map) {
+	BcMap *m = (BcMap*) map;
+	BC_SIG_ASSERT_LOCKED;
+	bc_vec_free(&m->ids);
+	free(m->slots);
+}
+#endif // NDEBUG
 
-		if (!result) return mid;
-		else if (result < 0) high = mid;
-		else low = mid + 1;
+size_t bc_vec_hash(size_t h, const void *data, size_t len) {
+
+	const uchar *bytes = (const uchar*) data;
+	size_t i;
+
+	for (i = 0; i < len; ++i) {
+		h ^= bytes[i];
+		h *= BC_VEC_HASH_PRIME;
+	}
+
+	return h;
+}
+
+static size_t bc_map_hash(const char *name) {
+	return bc_vec_hash(BC_VEC_HASH_INIT, name, strlen(name));
+}
+
+static BcMapSlot* bc_map_slot(const BcMap *restrict m, const char *name,
+                              size_t hash)
+{
+	size_t i, mask = m->cap - 1;
+	BcMapSlot *s;
+
+	for (i = hash & mask; (s = m->slots + i)->idx != BC_VEC_INVALID_IDX;
+	     i = (i + 1) & mask)
+	{
+		if (s->hash == hash &&
+		    !strcmp(name, ((BcId*) bc_vec_item(&m->ids, s->idx))->name))
+		{
+			break;
+		}
 	}
 
-	return low;
+	return s;
 }
 
-bool bc_map_insert(BcVec *restrict v, const char *name,
+static void bc_map_alloc(BcMap *restrict m, size_t cap) {
+
+	BcMapSlot *old = m->slots;
+	size_t i, old_cap = m->cap;
+
+	assert(cap && !(cap & (cap - 1)));
+
+	m->cap = cap;
+	m->slots = bc_vm_malloc(bc_vm_arraySize(cap, sizeof(BcMapSlot)));
+
+	for (i = 0; i < cap; ++i) m->slots[i].idx = BC_VEC_INVALID_IDX;
+
+	// The names are all different, so each goes in the first empty slot.
+	for (i = 0; i < old_cap; ++i) {
+
+		size_t j, mask = cap - 1;
+
+		if (old[i].idx == BC_VEC_INVALID_IDX) continue;
+
+		for (j = old[i].hash & mask; m->slots[j].idx != BC_VEC_INVALID_IDX;
+		     j = (j + 1) & mask);
+
+		m->slots[j] = old[i];
+	}
+
+	free(old);
+}
+
+bool bc_map_insert(BcMap *restrict m, const char *name,
                    size_t idx, size_t *restrict i)
 {
 	BcId id;
+	BcMapSlot *s;
+	size_t hash;
 
 	BC_SIG_ASSERT_LOCKED;
 
-	assert(v != NULL && name != NULL && i != NULL);
+	assert(m != NULL && name != NULL && i != NULL);
+
+	hash = bc_map_hash(name);
+
+	if (m->cap) {
+
+		s = bc_map_slot(m, name, hash);
+
+		if (s->idx != BC_VEC_INVALID_IDX) {
+			*i = s->idx;
+			return false;
+		}
+	}
 
-	*i = bc_map_find(v, name);
+	if (BC_VEC_HASH_FULL(m->ids.len, m->cap))
+		bc_map_alloc(m, m->cap ? bc_vm_growSize(m->cap, m->cap) : 16);
 
-	assert(*i <= v->len);
+	s = bc_map_slot(m, name, hash);
 
-	if (*i != v->len && !strcmp(name, ((BcId*) bc_vec_item(v, *i))->name))
-		return false;
+	assert(s->idx == BC_VEC_INVALID_IDX);
 
 	id.name = bc_vm_strdup(name);
 	id.idx = idx;
 
-	bc_vec_pushAt(v, &id, *i);
+	// Ids are appended in the order they are added. Only bc_map_truncate()
+	// removes them, and only from the end, so the index of any id it keeps
+	// stays valid.
+	*i = s->idx = m->ids.len;
+	s->hash = hash;
+
+	bc_vec_push(&m->ids, &id);
 
 	return true;
 }
 
-size_t bc_map_index(const BcVec *restrict v, const char *name) {
+#if BC_ENABLED && !BC_ENABLE_LIBRARY
+void bc_map_truncate(BcMap *restrict m, size_t len) {
 
 	size_t i;
 
-	assert(v != NULL && name != NULL);
+	BC_SIG_ASSERT_LOCKED;
+
+	assert(m != NULL && len <= m->ids.len);
+
+	if (len == m->ids.len) return;
+
+	// Release builds give the ids no destructor, so the names are freed here.
+	while (m->ids.len > len) {
+		BcId *id = bc_vec_top(&m->ids);
+		free(id->name);
+		m->ids.len -= 1;
+	}
+
+	for (i = 0; i < m->cap; ++i) m->slots[i].idx = BC_VEC_INVALID_IDX;
+
+	for (i = 0; i < len; ++i) {
+
+		const char *name = bc_map_item(m, i)->name;
+		size_t hash = bc_map_hash(name);
+		BcMapSlot *s = bc_map_slot(m, name, hash);
+
+		s->hash = hash;
+		s->idx = i;
+	}
+}
+#endif // BC_ENABLED && !BC_ENABLE_LIBRARY
+
+size_t bc_map_index(const BcMap *restrict m, const char *name) {
 
-	i = bc_map_find(v, name);
+	assert(m != NULL && name != NULL);
 
-	if (i >= v->len) return BC_VEC_INVALID_IDX;
+	if (!m->cap) return BC_VEC_INVALID_IDX;
 
-	return strcmp(name, ((BcId*) bc_vec_item(v, i))->name) ?
-	    BC_VEC_INVALID_IDX : i;
+	return bc_map_slot(m, name, bc_map_hash(name))->idx;
 }
@@ -37,6 +37,7 @@
 #include <ctype.h>
 #include <errno.h>
 #include <stdarg.h>
+#include <stdio.h>
 #include <string.h>
 
 #include <signal.h>
@@ -45,7 +46,13 @@
 
 #ifndef _WIN32
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/un.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
 #else // _WIN32
@@ -61,6 +68,7 @@
 #include <vm.h>
 #include <read.h>
 #include <bc.h>
+#include <bytecode.h>
 
 char output_bufs[BC_VM_BUF_SIZE];
 BcVm vm;
@@ -96,6 +104,16 @@ BC_NORETURN void bc_vm_jmp(void) {
 #if !BC_ENABLE_LIBRARY
 static void bc_vm_sig(int sig) {
 
+#if BC_VM_SERVER
+	// A signal stops the whole server, not just the request it interrupts.
+	if (vm.server != NULL) {
+		vm.server_quit = 1;
+		vm.status = BC_STATUS_QUIT;
+		if (!vm.sig_lock) BC_VM_JMP;
+		return;
+	}
+#endif // BC_VM_SERVER
+
 	// There is already a signal in flight.
 	if (vm.status == (sig_atomic_t) BC_STATUS_QUIT || vm.sig) {
 		if (!BC_TTY || sig != SIGINT) vm.status = BC_STATUS_QUIT;
@@ -157,12 +175,66 @@ void bc_vm_handleError(BcErr e) {
 	BC_VM_JMP;
 }
 #else // BC_ENABLE_LIBRARY
+static void bc_vm_defaultMsgs(void) {
+
+	size_t i;
+
+	vm.func_header = bc_err_func_header;
+
+	for (i = 0; i < BC_ERR_IDX_NELEMS + BC_ENABLED; ++i)
+		vm.err_ids[i] = bc_errs[i];
+	for (i = 0; i < BC_ERR_NELEMS; ++i) vm.err_msgs[i] = bc_err_msgs[i];
+}
+
+static void bc_vm_gettext(void) {
+
+#if BC_ENABLE_NLS
+	uchar id = 0;
+	int set = 1, msg = 1;
+	size_t i;
+
+	if (vm.locale == NULL) {
+		vm.catalog = BC_VM_INVALID_CATALOG;
+		bc_vm_defaultMsgs();
+		return;
+	}
+
+	vm.catalog = catopen(BC_MAINEXEC, NL_CAT_LOCALE);
+
+	if (vm.catalog == BC_VM_INVALID_CATALOG) {
+		bc_vm_defaultMsgs();
+		return;
+	}
+
+	vm.func_header = catgets(vm.catalog, set, msg, bc_err_func_header);
+
+	for (set += 1; msg <= BC_ERR_IDX_NELEMS + BC_ENABLED; ++msg)
+		vm.err_ids[msg - 1] = catgets(vm.catalog, set, msg, bc_errs[msg - 1]);
+
+	i = 0;
+	id = bc_err_ids[i];
+
+	for (set = id + 3, msg = 1; i < BC_ERR_NELEMS; ++i, ++msg) {
+
+		if (id != bc_err_ids[i]) {
+			msg = 1;
+			id = bc_err_ids[i];
+			set = id + 3;
+		}
+
+		vm.err_msgs[i] = catgets(vm.catalog, set, msg, bc_err_msgs[i]);
+	}
+#else // BC_ENABLE_NLS
+	bc_vm_defaultMsgs();
+#endif // BC_ENABLE_NLS
+}
+
 void bc_vm_handleError(BcErr e, size_t line, ...) {
 
 	BcStatus s;
 	va_list args;
 	uchar id = bc_err_ids[e];
-	const char* err_type = vm.err_ids[id];
+	const char* const* err_type = vm.err_ids + id;
 	sig_atomic_t lock;
 
 	assert(e < BC_ERR_NELEMS);
@@ -173,7 +245,7 @@ void bc_vm_handleError(BcErr e, size_t line, ...) {
 		if (BC_W) {
 			// Make sure to not return an error.
 			id = UCHAR_MAX;
-			err_type = vm.err_ids[BC_ERR_IDX_WARN];
+			err_type = vm.err_ids + BC_ERR_IDX_WARN;
 		}
 		else return;
 	}
@@ -181,6 +253,10 @@ void bc_vm_handleError(BcErr e, size_t line, ...) {
 
 	BC_SIG_TRYLOCK(lock);
 
+	// The messages, and the catalog they may come from, are only loaded
+	// once an error actually needs to be printed.
+	if (BC_ERR(vm.func_header == NULL)) bc_vm_gettext();
+
 	// Make sure all of stdout is written first.
 	s = bc_file_flushErr(&vm.fout);
 
@@ -191,7 +267,7 @@ void bc_vm_handleError(BcErr e, size_t line, ...) {
 
 	va_start(args, line);
 	bc_file_putchar(&vm.ferr, '\n');
-	bc_file_puts(&vm.ferr, err_type);
+	bc_file_puts(&vm.ferr, *err_type);
 	bc_file_putchar(&vm.ferr, ' ');
 	bc_file_vprintf(&vm.ferr, vm.err_msgs[e], args);
 	va_end(args);
@@ -332,6 +408,10 @@ void bc_vm_shutdown(void) {
 	if (BC_TTY) bc_history_free(&vm.history);
 #endif // BC_ENABLE_HISTORY
 
+#if BC_PROG_PROFILE
+	if (vm.prog.prof != NULL) bc_program_report(&vm.prog);
+#endif // BC_PROG_PROFILE
+
 #ifndef NDEBUG
 #if !BC_ENABLE_LIBRARY
 	bc_vec_free(&vm.env_args);
@@ -454,7 +534,10 @@ static void bc_vm_clean(void) {
 	if (good) bc_program_reset(&vm.prog);
 
 #if BC_ENABLED
-	if (good && BC_IS_BC) good = !BC_PARSE_NO_EXEC(&vm.prs);
+	// Code that ran to the end can go too, or streaming a file would keep all
+	// of it.
+	if (BC_IS_BC)
+		good = (good || !vm.status) && !BC_PARSE_NO_EXEC(&vm.prs);
 #endif // BC_ENABLED
 
 #if DC_ENABLED
@@ -506,7 +589,15 @@ static void bc_vm_process(const char *text) {
 
 		while (BC_PARSE_CAN_PARSE(vm.prs)) vm.parse(&vm.prs);
 
-		if(BC_IS_DC || !BC_PARSE_NO_EXEC(&vm.prs)) bc_program_exec(&vm.prog);
+		if(BC_IS_DC || !BC_PARSE_NO_EXEC(&vm.prs)) {
+#if BC_ENABLED
+			if (BC_IS_BC) bc_parse_optimize(&vm.prs);
+#endif // BC_ENABLED
+#if BC_VM_CACHE
+			if (vm.cache != NULL) bc_bytecode_filePart(vm.cache, &vm.prog);
+#endif // BC_VM_CACHE
+			bc_program_exec(&vm.prog);
+		}
 
 		assert(BC_IS_DC || vm.prog.results.len == 0);
 
@@ -537,9 +628,138 @@ static void bc_vm_endif(void) {
 }
 #endif // BC_ENABLED
 
+#if BC_VM_CACHE
+// Saved code is only trusted if nobody else could have written it, so a
+// directory that others can write to is not used.
+static const char* bc_vm_cacheDir(const char *dir) {
+
+	struct stat dstat;
+
+	if (dir == NULL || stat(dir, &dstat) == -1 || !S_ISDIR(dstat.st_mode) ||
+	    (dstat.st_mode & (S_IWGRP | S_IWOTH)))
+	{
+		return NULL;
+	}
+
+	return dir;
+}
+
+static char* bc_vm_cachePath(const BcBytecodeKey *key) {
+
+	size_t i, len = strlen(vm.cache_dir), digits = 2 * sizeof(key->digest);
+	char *path;
+
+	BC_SIG_ASSERT_LOCKED;
+
+	// The directory, a slash, the digest in hex, and the nul byte.
+	path = bc_vm_malloc(len + digits + 2);
+
+	memcpy(path, vm.cache_dir, len);
+	path[len] = '/';
+
+	for (i = 0; i < digits; ++i) {
+		uint64_t half = key->digest[i / 16] >> (60 - i % 16 * 4);
+		path[len + 1 + i] = bc_num_hex_digits[half & 0xf];
+	}
+
+	path[len + digits + 1] = '\0';
+
+	return path;
+}
+
+static char* bc_vm_cacheMap(const char *path, size_t *len) {
+
+	struct stat pstat;
+	void *map;
+	int fd;
+
+	BC_SIG_ASSERT_LOCKED;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) return NULL;
+
+	// Like the directory, the file has to be this user's, and nobody else can
+	// be able to write to it.
+	if (fstat(fd, &pstat) == -1 || !S_ISREG(pstat.st_mode) ||
+	    !pstat.st_size || pstat.st_uid != geteuid() ||
+	    (pstat.st_mode & (S_IWGRP | S_IWOTH)))
+	{
+		close(fd);
+		return NULL;
+	}
+
+	*len = (size_t) pstat.st_size;
+	map = mmap(NULL, *len, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	close(fd);
+
+	return map != MAP_FAILED ? map : NULL;
+}
+
+static void bc_vm_cacheSave(const char *path, const BcBytecodeFile *f) {
+
+	char *tmp;
+	size_t len = strlen(path);
+	ssize_t w;
+	int fd;
+
+	BC_SIG_ASSERT_LOCKED;
+
+	tmp = bc_vm_malloc(len + sizeof(".XXXXXX"));
+	memcpy(tmp, path, len);
+	memcpy(tmp + len, ".XXXXXX", sizeof(".XXXXXX"));
+
+	// The file is written under another name first so that another bc never
+	// reads half of it. It replaces any file that was there, which could only
+	// have been rejected. Failing to save it is not an error.
+	fd = mkstemp(tmp);
+
+	if (fd >= 0) {
+
+		w = write(fd, f->buf.v, f->buf.len);
+
+		if (close(fd) || w < 0 || (size_t) w != f->buf.len ||
+		    rename(tmp, path))
+		{
+			unlink(tmp);
+		}
+	}
+
+	free(tmp);
+}
+
+static void bc_vm_cacheRun(BcBytecodeReader *r, bool quit) {
+
+	while (bc_bytecode_fileNext(r, &vm.prog)) {
+
+		bc_program_exec(&vm.prog);
+
+		assert(vm.prog.results.len == 0);
+
+		if (BC_I) bc_file_flush(&vm.fout);
+	}
+
+	// This is what the parser does when it gets to quit.
+	if (quit) {
+		vm.status = BC_STATUS_QUIT;
+		BC_VM_JMP;
+	}
+}
+#endif // BC_VM_CACHE
+
 static void bc_vm_file(const char *file) {
 
 	char *data = NULL;
+	size_t len;
+	bool map = false;
+#if BC_VM_CACHE
+	BcBytecodeFile cache;
+	BcBytecodeReader r;
+	BcBytecodeKey key;
+	// It is only set before the setjmp, but GCC cannot tell.
+	char* volatile path = NULL;
+	bool quit = false;
+#endif // BC_VM_CACHE
 
 	assert(!vm.sig_pop);
 
@@ -547,12 +767,60 @@ static void bc_vm_file(const char *file) {
 
 	BC_SIG_LOCK;
 
-	bc_read_file(file, &data);
+#ifndef _WIN32
+	data = bc_read_map(file, &len);
+	map = (data != NULL);
+
+	// The lexer checks a mapped file for binary bytes as it goes, but a NUL
+	// would end the text early, so that is checked here. The scan stops at
+	// len, where bc_read_map() put the NUL that ends the text.
+	if (map && BC_ERR(memchr(data, '\0', len) != NULL)) {
+		munmap(data, len);
+		bc_vm_verr(BC_ERR_FATAL_BIN_FILE, file);
+	}
+#endif // _WIN32
+
+	if (!map) {
+		bc_read_file(file, &data);
+		len = strlen(data);
+	}
+
+	vm.prs.l.bin = map;
+
+#if BC_VM_CACHE
+	r.buf = NULL;
+
+	// The saved code was parsed with the default flags.
+	if (BC_IS_BC && vm.cache_dir != NULL && !BC_IS_POSIX && !BC_N) {
+
+		bc_bytecode_key(&vm.prog, data, len, &key);
+		path = bc_vm_cachePath(&key);
+
+		r.buf = bc_vm_cacheMap(path, &r.len);
+
+		if (r.buf != NULL && !bc_bytecode_fileOpen(&r, &key, &quit)) {
+			munmap((void*) r.buf, r.len);
+			r.buf = NULL;
+		}
+
+		if (r.buf == NULL) {
+			bc_bytecode_fileInit(&cache, &vm.prog);
+			vm.cache = &cache;
+		}
+	}
+#endif // BC_VM_CACHE
 
 	BC_SETJMP_LOCKED(err);
 
 	BC_SIG_UNLOCK;
 
+#if BC_VM_CACHE
+	if (r.buf != NULL) {
+		bc_vm_cacheRun(&r, quit);
+		goto err;
+	}
+#endif // BC_VM_CACHE
+
 	bc_vm_process(data);
 
 #if BC_ENABLED
@@ -562,7 +830,33 @@ static void bc_vm_file(const char *file) {
 err:
 	BC_SIG_MAYLOCK;
 
-	free(data);
+#if BC_VM_CACHE
+	if (path != NULL) {
+
+		// The file is only saved if all of it was parsed, or if it ended at
+		// quit, and if nothing in it turned saving off.
+		if (vm.cache != NULL && (vm.status == BC_STATUS_SUCCESS ||
+		    (vm.status == BC_STATUS_QUIT && cache.quit)))
+		{
+			bc_bytecode_fileEnd(&cache, &key);
+			bc_vm_cacheSave(path, &cache);
+		}
+
+		if (r.buf != NULL) munmap((void*) r.buf, r.len);
+		else bc_bytecode_fileFree(&cache);
+
+		vm.cache = NULL;
+		free(path);
+	}
+#endif // BC_VM_CACHE
+
+#ifndef _WIN32
+	if (map) munmap(data, len);
+#endif // _WIN32
+	if (!map) free(data);
+
+	vm.prs.l.bin = false;
+
 	bc_vm_clean();
 
 	// bc_program_reset(), called by bc_vm_clean(), resets the status.
@@ -572,174 +866,1003 @@ err:
 	BC_LONGJMP_CONT;
 }
 
-static void bc_vm_stdin(void) {
-
-	BcStatus s;
-	BcVec buf, buffer;
-	size_t string = 0;
-	bool comment = false, hash = false;
-
-	bc_lex_file(&vm.prs.l, bc_program_stdin_name);
+static void bc_vm_scan(const char *str, size_t len, size_t *string,
+                       bool *comment, bool *hash)
+{
+	char c2;
+	size_t i;
 
-	BC_SIG_LOCK;
-	bc_vec_init(&buffer, sizeof(uchar), NULL);
-	bc_vec_init(&buf, sizeof(uchar), NULL);
-	bc_vec_pushByte(&buffer, '\0');
-	BC_SETJMP_LOCKED(err);
-	BC_SIG_UNLOCK;
+	for (i = 0; i < len; ++i) {
 
-restart:
+		bool notend = len > i + 1;
+		uchar c = (uchar) str[i];
 
-	// This loop is complex because the vm tries not to send any lines that end
-	// with a backslash to the parser. The reason for that is because the parser
-	// treats a backslash+newline combo as whitespace, per the bc spec. In that
-	// case, and for strings and comments, the parser will expect more stuff.
-	while ((!(s = bc_read_line(&buf, ">>> ")) ||
-	        (vm.eof = (s == BC_STATUS_EOF))) && buf.len > 1)
-	{
-		char c2, *str = buf.v;
-		size_t i, len = buf.len - 1;
+		*hash = (!*comment && !*string && ((*hash && c != '\n') ||
+		                                   (!*hash && c == '#')));
 
-		for (i = 0; i < len; ++i) {
+		if (!*hash && !*comment && (i - 1 > len || str[i - 1] != '\\')) {
+			if (BC_IS_BC) *string ^= (c == '"');
+			else if (c == ']') *string -= 1;
+			else if (c == '[') *string += 1;
+		}
 
-			bool notend = len > i + 1;
-			uchar c = (uchar) str[i];
+		if (BC_IS_BC && !*hash && !*string && notend) {
 
-			hash = (!comment && !string && ((hash && c != '\n') ||
-			                                (!hash && c == '#')));
+			c2 = str[i + 1];
 
-			if (!hash && !comment && (i - 1 > len || str[i - 1] != '\\')) {
-				if (BC_IS_BC) string ^= (c == '"');
-				else if (c == ']') string -= 1;
-				else if (c == '[') string += 1;
+			if (c == '/' && !*comment && c2 == '*') {
+				*comment = true;
+				i += 1;
 			}
-
-			if (BC_IS_BC && !hash && !string && notend) {
-
-				c2 = str[i + 1];
-
-				if (c == '/' && !comment && c2 == '*') {
-					comment = true;
-					i += 1;
-				}
-				else if (c == '*' && comment && c2 == '/') {
-					comment = false;
-					i += 1;
-				}
+			else if (c == '*' && *comment && c2 == '/') {
+				*comment = false;
+				i += 1;
 			}
 		}
+	}
+}
 
-		bc_vec_concat(&buffer, buf.v);
+static bool bc_vm_blocksFill(BcVec *data, size_t start, int fd) {
 
-		if (string || comment) continue;
-		if (len >= 2 && str[len - 2] == '\\' && str[len - 1] == '\n') continue;
-#if BC_ENABLE_HISTORY
-		if (vm.history.stdin_has_data) continue;
-#endif // BC_ENABLE_HISTORY
+	size_t len = data->len - 1 - start;
+	ssize_t r;
 
-		bc_vm_process(buffer.v);
-		bc_vec_empty(&buffer);
+	memmove(data->v, data->v + start, len);
+	bc_vec_npop(data, data->len - len);
 
-		if (vm.eof) break;
-		else bc_vm_clean();
+	// Anything read() left behind comes first.
+	if (fd == STDIN_FILENO && vm.buf_len) {
+		bc_vec_npush(data, vm.buf_len, vm.buf);
+		bc_vec_pushByte(data, '\0');
+		vm.buf_len = 0;
+		return true;
 	}
 
-	if (!BC_STATUS_IS_ERROR(s)) {
-		if (BC_ERR(comment))
-			bc_parse_err(&vm.prs, BC_ERR_PARSE_COMMENT);
-		else if (BC_ERR(string))
-			bc_parse_err(&vm.prs, BC_ERR_PARSE_STRING);
-#if BC_ENABLED
-		else if (BC_IS_BC) bc_vm_endif();
-#endif // BC_ENABLED
-	}
+	bc_vec_expand(data, len + BC_VM_STDIN_BLOCK_SIZE + 1);
 
-err:
-	BC_SIG_MAYLOCK;
+	do {
 
-	bc_vm_clean();
+		BC_SIG_LOCK;
 
-	vm.status = vm.status == BC_STATUS_ERROR_FATAL ||
-	            vm.status == BC_STATUS_QUIT || !BC_I ?
-	            vm.status : BC_STATUS_SUCCESS;
+		r = read(fd, data->v + len, BC_VM_STDIN_BLOCK_SIZE);
 
-	if (!vm.status && !vm.eof) {
-		bc_vec_empty(&buffer);
-		BC_LONGJMP_STOP;
-		BC_SIG_UNLOCK;
-		goto restart;
-	}
+		if (BC_UNLIKELY(r < 0)) {
 
-	bc_vec_free(&buf);
-	bc_vec_free(&buffer);
+			BC_SIG_UNLOCK;
 
-	BC_LONGJMP_CONT;
-}
+			if (errno != EINTR) bc_vm_err(BC_ERR_FATAL_IO_ERR);
+		}
+		else BC_SIG_UNLOCK;
 
-#if BC_ENABLED
-static void bc_vm_load(const char *name, const char *text) {
+	} while (r < 0);
 
-	bc_lex_file(&vm.prs.l, name);
-	bc_parse_text(&vm.prs, text);
+	data->len = len + (size_t) r;
+	bc_vec_pushByte(data, '\0');
 
-	while (vm.prs.l.t != BC_LEX_EOF) vm.parse(&vm.prs);
+	return r != 0;
 }
-#endif // BC_ENABLED
 
-static void bc_vm_defaultMsgs(void) {
+static void bc_vm_blocksRun(BcVec *data, BcVec *buffer, size_t start,
+                            size_t end, int fd)
+{
+	const char *str = data->v + start;
 
-	size_t i;
+	if (BC_ERR(bc_read_binary(str, end - start)))
+		bc_vm_verr(BC_ERR_FATAL_BIN_FILE, vm.file);
 
-	vm.func_header = bc_err_func_header;
+	bc_vec_npop(buffer, buffer->len);
+	bc_vec_npush(buffer, end - start, str);
+	bc_vec_pushByte(buffer, '\0');
 
-	for (i = 0; i < BC_ERR_IDX_NELEMS + BC_ENABLED; ++i)
-		vm.err_ids[i] = bc_errs[i];
-	for (i = 0; i < BC_ERR_NELEMS; ++i) vm.err_msgs[i] = bc_err_msgs[i];
+	if (fd == STDIN_FILENO) {
+		vm.stdin_buf = data->v + end;
+		vm.stdin_len = data->len - 1 - end;
+	}
+
+	bc_vm_process(buffer->v);
 }
 
-static void bc_vm_gettext(void) {
+// This does what bc_vm_stdin() does, but it reads a block at a time and only
+// scans the lines that could start or end a string or comment. The caller owns
+// data and buffer, so that it can free them on an error.
+static void bc_vm_blocksLoop(BcVec *data, BcVec *buffer, int fd) {
 
-#if BC_ENABLE_NLS
-	uchar id = 0;
-	int set = 1, msg = 1;
-	size_t i;
+	size_t start = 0, i = 0, string = 0;
+	bool comment = false, hash = false, eof = false;
+	const char *set = BC_IS_BC ? "\n\"#/\\" : "\n[]#\\";
 
-	if (vm.locale == NULL) {
-		vm.catalog = BC_VM_INVALID_CATALOG;
-		bc_vm_defaultMsgs();
-		return;
-	}
+	while (true) {
 
-	vm.catalog = catopen(BC_MAINEXEC, NL_CAT_LOCALE);
+		char *line = data->v + i;
+		char *nl = memchr(line, '\n', data->len - 1 - i);
+		size_t len;
 
-	if (vm.catalog == BC_VM_INVALID_CATALOG) {
-		bc_vm_defaultMsgs();
-		return;
-	}
+		if (nl == NULL) {
 
-	vm.func_header = catgets(vm.catalog, set, msg, bc_err_func_header);
+			if (!eof) {
+				eof = !bc_vm_blocksFill(data, start, fd);
+				i -= start;
+				start = 0;
+				continue;
+			}
 
-	for (set += 1; msg <= BC_ERR_IDX_NELEMS + BC_ENABLED; ++msg)
-		vm.err_ids[msg - 1] = catgets(vm.catalog, set, msg, bc_errs[msg - 1]);
+			// The last line has no newline.
+			if (i == data->len - 1) break;
+			nl = data->v + data->len - 2;
+		}
 
-	i = 0;
-	id = bc_err_ids[i];
+		len = (size_t) (nl + 1 - line);
 
-	for (set = id + 3, msg = 1; i < BC_ERR_NELEMS; ++i, ++msg) {
+		if (string || comment || hash || line[strcspn(line, set)] != '\n')
+			bc_vm_scan(line, len, &string, &comment, &hash);
 
-		if (id != bc_err_ids[i]) {
-			msg = 1;
-			id = bc_err_ids[i];
-			set = id + 3;
-		}
+		i += len;
 
-		vm.err_msgs[i] = catgets(vm.catalog, set, msg, bc_err_msgs[i]);
+		if (string || comment) continue;
+		if (len >= 2 && line[len - 2] == '\\' && line[len - 1] == '\n')
+			continue;
+
+		bc_vm_blocksRun(data, buffer, start, i, fd);
+
+		// read() may have taken some of the lines after this one.
+		if (fd == STDIN_FILENO) i = data->len - 1 - vm.stdin_len;
+
+		if (eof && i == data->len - 1) break;
+		else bc_vm_clean();
+
+		start = i;
 	}
-#else // BC_ENABLE_NLS
-	bc_vm_defaultMsgs();
-#endif // BC_ENABLE_NLS
+
+	if (BC_ERR(bc_read_binary(data->v + start, data->len - 1 - start)))
+		bc_vm_verr(BC_ERR_FATAL_BIN_FILE, vm.file);
+
+	if (BC_ERR(comment)) bc_parse_err(&vm.prs, BC_ERR_PARSE_COMMENT);
+	else if (BC_ERR(string)) bc_parse_err(&vm.prs, BC_ERR_PARSE_STRING);
+#if BC_ENABLED
+	else if (BC_IS_BC) bc_vm_endif();
+#endif // BC_ENABLED
+}
+
+static void bc_vm_blocks(int fd) {
+
+	BcVec data, buffer;
+
+	BC_SIG_LOCK;
+	bc_vec_init(&data, sizeof(char), NULL);
+	bc_vec_init(&buffer, sizeof(char), NULL);
+	bc_vec_pushByte(&data, '\0');
+	BC_SETJMP_LOCKED(err);
+	BC_SIG_UNLOCK;
+
+	bc_vm_blocksLoop(&data, &buffer, fd);
+
+err:
+	BC_SIG_MAYLOCK;
+
+	bc_vm_clean();
+
+	if (fd == STDIN_FILENO) vm.stdin_len = 0;
+	else close(fd);
+
+	bc_vec_free(&data);
+	bc_vec_free(&buffer);
+
+	if (vm.status == (sig_atomic_t) BC_STATUS_SUCCESS) BC_LONGJMP_STOP;
+
+	BC_LONGJMP_CONT;
+}
+
+static void bc_vm_stream(const char *file) {
+
+	struct stat pstat;
+	int fd;
+
+	assert(!vm.sig_pop);
+
+	bc_lex_file(&vm.prs.l, file);
+
+	BC_SIG_LOCK;
+
+	fd = open(file, O_RDONLY);
+	if (BC_ERR(fd < 0)) bc_vm_verr(BC_ERR_FATAL_FILE_ERR, file);
+
+	if (BC_ERR(fstat(fd, &pstat) == -1)) {
+		close(fd);
+		bc_vm_err(BC_ERR_FATAL_IO_ERR);
+	}
+
+	if (BC_ERR(S_ISDIR(pstat.st_mode))) {
+		close(fd);
+		bc_vm_verr(BC_ERR_FATAL_PATH_DIR, file);
+	}
+
+	BC_SIG_UNLOCK;
+
+	bc_vm_blocks(fd);
+}
+
+static void bc_vm_stdin(void) {
+
+	BcStatus s;
+	BcVec buf, buffer;
+	size_t string = 0;
+	bool comment = false, hash = false;
+
+	bc_lex_file(&vm.prs.l, bc_program_stdin_name);
+
+	if (!BC_I) {
+		bc_vm_blocks(STDIN_FILENO);
+		return;
+	}
+
+	BC_SIG_LOCK;
+	bc_vec_init(&buffer, sizeof(uchar), NULL);
+	bc_vec_init(&buf, sizeof(uchar), NULL);
+	bc_vec_pushByte(&buffer, '\0');
+	BC_SETJMP_LOCKED(err);
+	BC_SIG_UNLOCK;
+
+restart:
+
+	// This loop is complex because the vm tries not to send any lines that end
+	// with a backslash to the parser. The reason for that is because the parser
+	// treats a backslash+newline combo as whitespace, per the bc spec. In that
+	// case, and for strings and comments, the parser will expect more stuff.
+	while ((!(s = bc_read_line(&buf, ">>> ")) ||
+	        (vm.eof = (s == BC_STATUS_EOF))) && buf.len > 1)
+	{
+		char *str = buf.v;
+		size_t len = buf.len - 1;
+
+		bc_vm_scan(str, len, &string, &comment, &hash);
+
+		bc_vec_concat(&buffer, buf.v);
+
+		if (string || comment) continue;
+		if (len >= 2 && str[len - 2] == '\\' && str[len - 1] == '\n') continue;
+#if BC_ENABLE_HISTORY
+		if (vm.history.stdin_has_data) continue;
+#endif // BC_ENABLE_HISTORY
+
+		bc_vm_process(buffer.v);
+		bc_vec_empty(&buffer);
+
+		if (vm.eof) break;
+		else bc_vm_clean();
+	}
+
+	if (!BC_STATUS_IS_ERROR(s)) {
+		if (BC_ERR(comment))
+			bc_parse_err(&vm.prs, BC_ERR_PARSE_COMMENT);
+		else if (BC_ERR(string))
+			bc_parse_err(&vm.prs, BC_ERR_PARSE_STRING);
+#if BC_ENABLED
+		else if (BC_IS_BC) bc_vm_endif();
+#endif // BC_ENABLED
+	}
+
+err:
+	BC_SIG_MAYLOCK;
+
+	bc_vm_clean();
+
+	vm.status = vm.status == BC_STATUS_ERROR_FATAL ||
+	            vm.status == BC_STATUS_QUIT || !BC_I ?
+	            vm.status : BC_STATUS_SUCCESS;
+
+	if (!vm.status && !vm.eof) {
+		bc_vec_empty(&buffer);
+		BC_LONGJMP_STOP;
+		BC_SIG_UNLOCK;
+		goto restart;
+	}
+
+	bc_vec_free(&buf);
+	bc_vec_free(&buffer);
+
+	BC_LONGJMP_CONT;
+}
+
+#if BC_ENABLED
+static void bc_vm_load(const char *name, const char *text) {
+
+	bc_lex_file(&vm.prs.l, name);
+	bc_parse_text(&vm.prs, text);
+
+	vm.prs.lib = true;
+
+	while (vm.prs.l.t != BC_LEX_EOF) vm.parse(&vm.prs);
+
+	vm.prs.lib = false;
+}
+
+static void bc_vm_loadLib(const char *name, const char *text,
+                          const uchar *code, size_t len)
+{
+	// The saved code was parsed with the default flags, so the text is still
+	// parsed if any flag changes what the parser does.
+	if (!len || BC_IS_POSIX || BC_N ||
+	    !bc_bytecode_load(&vm.prog, (const char*) code, len, true))
+	{
+		bc_vm_load(name, text);
+	}
+}
+#endif // BC_ENABLED
+
+#if BC_VM_SERVER
+static void bc_vm_serverInit(BcVmServer *srv) {
+
+	size_t i;
+
+	BC_SIG_ASSERT_LOCKED;
+
+	bc_program_snap(&vm.prog, &srv->snap);
+
+	bc_vec_init(&srv->fns, sizeof(uchar), NULL);
+	bc_vec_init(&srv->pids, sizeof(pid_t), NULL);
+
+	srv->redef = false;
+	srv->status = BC_STATUS_SUCCESS;
+	srv->in = -1;
+	srv->bound = false;
+	srv->batch = false;
+
+	// A request may redefine a function that the program had, so their
+	// bytecode is kept to put them back afterward.
+	if (srv->snap.fns > BC_PROG_READ + 1) {
+
+		BcVec redefs;
+		BcBytecodeMark mark;
+
+		bc_vec_init(&redefs, sizeof(size_t), NULL);
+
+		for (i = BC_PROG_READ + 1; i < srv->snap.fns; ++i)
+			bc_vec_push(&redefs, &i);
+
+		bc_bytecode_mark(&vm.prog, &mark);
+		bc_bytecode_save(&vm.prog, &mark, &redefs, &srv->fns);
+
+		bc_vec_free(&redefs);
+	}
+}
+
+static void bc_vm_serverFree(BcVmServer *srv) {
+
+	size_t i;
+
+	BC_SIG_ASSERT_LOCKED;
+
+	vm.server = NULL;
+
+	for (i = 0; i < srv->pids.len; ++i)
+		kill(*((pid_t*) bc_vec_item(&srv->pids, i)), SIGTERM);
+
+	for (i = 0; i < srv->pids.len; ++i)
+		waitpid(*((pid_t*) bc_vec_item(&srv->pids, i)), NULL, 0);
+
+	bc_vec_free(&srv->pids);
+	bc_vec_free(&srv->fns);
+	bc_program_snapFree(&srv->snap);
+}
+
+static void bc_vm_serverRun(const char *text, size_t line) {
+
+	BcVmServer *srv = vm.server;
+
+	BC_SIG_LOCK;
+
+	vm.nchars = 0;
+
+	BC_SETJMP_LOCKED(err);
+
+	BC_SIG_UNLOCK;
+
+	bc_lex_file(&vm.prs.l, bc_program_stdin_name);
+	vm.prs.l.line = line;
+
+	bc_vm_process(text);
+	bc_vm_endif();
+
+err:
+	BC_SIG_MAYLOCK;
+
+	// Errors, halt, and quit only end the request. The status is cleared
+	// first because bc_parse_reset() jumps on any other; a signal that stops
+	// the server sets it again at the end.
+	if (vm.status != BC_STATUS_SUCCESS) {
+
+		if (BC_STATUS_IS_ERROR(vm.status) && !srv->status)
+			srv->status = (BcStatus) vm.status;
+
+		vm.status = BC_STATUS_SUCCESS;
+		bc_parse_reset(&vm.prs);
+	}
+
+	// The next request starts from the state the server was in before the
+	// first one.
+	bc_program_restore(&vm.prog, &srv->snap);
+
+	if (vm.server_quit) vm.status = BC_STATUS_QUIT;
+	else BC_LONGJMP_STOP;
+
+	BC_LONGJMP_CONT;
+
+	if (srv->redef) {
+
+		bool good = bc_bytecode_load(&vm.prog, srv->fns.v, srv->fns.len, true);
+
+		assert(good);
+		BC_UNUSED(good);
+
+		srv->redef = false;
+	}
+}
+
+// Reads until end of file, or until a NUL byte if end is not NULL, in which
+// case end is set to whether it was end of file.
+static void bc_vm_serverRead(int fd, BcVec *buf, bool *end) {
+
+	char data[BC_VM_BUF_SIZE];
+	ssize_t r;
+	char *nul = NULL;
+
+	while (nul == NULL && (r = read(fd, data, BC_VM_BUF_SIZE)) != 0) {
+
+		if (BC_ERR(r < 0)) {
+			if (errno == EINTR) continue;
+			bc_vm_err(BC_ERR_FATAL_IO_ERR);
+		}
+
+		nul = memchr(data, '\0', (size_t) r);
+
+		if (BC_ERR(nul != NULL && end == NULL))
+			bc_vm_verr(BC_ERR_FATAL_BIN_FILE, bc_program_stdin_name);
+
+		if (nul != NULL) r = nul - data;
+
+		BC_SIG_LOCK;
+		bc_vec_npush(buf, (size_t) r, data);
+		BC_SIG_UNLOCK;
+	}
+
+	if (end != NULL) *end = (nul == NULL);
+
+	BC_SIG_LOCK;
+	bc_vec_pushByte(buf, '\0');
+	BC_SIG_UNLOCK;
+}
+
+static void bc_vm_serverWrite(int fd, const char *data, size_t len) {
+
+	while (len) {
+
+		ssize_t r = write(fd, data, len);
+
+		if (BC_ERR(r < 0)) {
+			if (errno == EINTR) continue;
+			bc_vm_err(BC_ERR_FATAL_IO_ERR);
+		}
+
+		data += r;
+		len -= (size_t) r;
+	}
+}
+
+static void bc_vm_serverRequest(int fd, BcVec *buf) {
+
+	BC_SIG_LOCK;
+
+	bc_vec_npop(buf, buf->len);
+
+	vm.fout.fd = vm.ferr.fd = fd;
+
+	BC_SETJMP_LOCKED(err);
+
+	BC_SIG_UNLOCK;
+
+	// The request is everything the client sends before it shuts down its
+	// side of the connection.
+	bc_vm_serverRead(fd, buf, NULL);
+	bc_vm_serverRun(buf->v, 1);
+
+err:
+	BC_SIG_MAYLOCK;
+
+	// A request that could not be read does not stop the server either.
+	vm.status = BC_STATUS_SUCCESS;
+
+	// If the client is gone, there is nobody left to tell.
+	bc_file_flushErr(&vm.fout);
+	bc_file_flushErr(&vm.ferr);
+
+	vm.fout.fd = STDOUT_FILENO;
+	vm.ferr.fd = STDERR_FILENO;
+
+	close(fd);
+
+	if (vm.server_quit) vm.status = BC_STATUS_QUIT;
+	else BC_LONGJMP_STOP;
+
+	BC_LONGJMP_CONT;
+}
+
+static void bc_vm_server(void) {
+
+	BcVmServer srv;
+	BcVec buf;
+	struct sockaddr_un addr;
+	struct sigaction sa;
+	size_t i, len = strlen(vm.server_path);
+	int fd;
+
+	// The libraries set scale in main, and that has to be in the snapshot.
+	bc_program_exec(&vm.prog);
+
+	BC_SIG_LOCK;
+
+	bc_vec_init(&buf, sizeof(char), NULL);
+	bc_vm_serverInit(&srv);
+
+	BC_SETJMP_LOCKED(err);
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+
+	if (BC_ERR(len >= sizeof(addr.sun_path)))
+		bc_vm_verr(BC_ERR_FATAL_FILE_ERR, vm.server_path);
+
+	memcpy(addr.sun_path, vm.server_path, len + 1);
+
+	srv.in = socket(AF_UNIX, SOCK_STREAM, 0);
+
+	if (BC_ERR(srv.in < 0 ||
+	           bind(srv.in, (struct sockaddr*) &addr, sizeof(addr)) < 0))
+	{
+		bc_vm_verr(BC_ERR_FATAL_FILE_ERR, vm.server_path);
+	}
+
+	srv.bound = true;
+
+	if (BC_ERR(listen(srv.in, SOMAXCONN) < 0))
+		bc_vm_verr(BC_ERR_FATAL_FILE_ERR, vm.server_path);
+
+	// Requests cannot give read() any input, so it just sees end of file.
+	fd = open("/dev/null", O_RDONLY);
+	if (fd >= 0) {
+		dup2(fd, STDIN_FILENO);
+		close(fd);
+	}
+
+	// A client that hangs up early must not take the server with it.
+	sigemptyset(&sa.sa_mask);
+	sa.sa_handler = SIG_IGN;
+	sa.sa_flags = 0;
+	sigaction(SIGPIPE, &sa, NULL);
+
+	bc_file_flush(&vm.fout);
+
+	// The workers all accept on the same socket, and the kernel hands each
+	// connection to just one of them.
+	for (i = 1; srv.bound && i < vm.jobs; ++i) {
+
+		pid_t pid = fork();
+
+		if (BC_ERR(pid < 0)) bc_vm_err(BC_ERR_FATAL_IO_ERR);
+
+		if (pid) bc_vec_push(&srv.pids, &pid);
+		else {
+			// Only the first process cleans up the workers and the file.
+			srv.bound = false;
+			bc_vec_npop(&srv.pids, srv.pids.len);
+		}
+	}
+
+	vm.server = &srv;
+
+	BC_SIG_UNLOCK;
+
+	// This only ends with a signal.
+	while (true) {
+
+		fd = accept(srv.in, NULL, NULL);
+
+		if (BC_ERR(fd < 0)) {
+			if (errno == EINTR || errno == ECONNABORTED) continue;
+			bc_vm_err(BC_ERR_FATAL_IO_ERR);
+		}
+
+		bc_vm_serverRequest(fd, &buf);
+	}
+
+err:
+	BC_SIG_MAYLOCK;
+
+	if (srv.in >= 0) close(srv.in);
+	if (srv.bound) unlink(vm.server_path);
+
+	bc_vm_serverFree(&srv);
+	bc_vec_free(&buf);
+
+	BC_LONGJMP_CONT;
+}
+
+// Runs each line of text as its own request. A block of lines is ended by
+// the NUL byte that the caller put there.
+static void bc_vm_batchLines(char *text, size_t line) {
+
+	char *end;
+
+	for (; *text; text = end, ++line) {
+
+		char c;
+
+		end = strchr(text, '\n');
+		end = end != NULL ? end + 1 : text + strlen(text);
+
+		if (*text == '\n') continue;
+
+		c = *end;
+		*end = '\0';
+
+		bc_vm_serverRun(text, line);
+
+		*end = c;
+	}
+}
+
+// Runs the blocks of lines that it gets from in, starting with the given one
+// and skipping the ones that the others get. Output and errors go to out as
+// records, and buf belongs to the caller, which frees it on an error.
+static void bc_vm_batchWorker(int in, int out, BcVec *buf, size_t block,
+                              size_t jobs)
+{
+	bool eof = false;
+	size_t rec[2];
+
+	vm.fout.fd = vm.ferr.fd = out;
+
+	while (true) {
+
+		bc_vec_npop(buf, buf->len);
+
+		bc_vm_serverRead(in, buf, &eof);
+		if (eof) break;
+
+		vm.server->status = BC_STATUS_SUCCESS;
+
+		bc_vm_batchLines(buf->v, block * BC_VM_BATCH_LINES + 1);
+
+		bc_file_flush(&vm.fout);
+
+		// The first process waits for this to know the block is done.
+		rec[0] = BC_VM_BATCH_END;
+		rec[1] = (size_t) vm.server->status;
+
+		bc_vm_serverWrite(out, (const char*) rec, sizeof(rec));
+
+		block += jobs;
+	}
+}
+
+// Reads len bytes from a worker. A worker that died cannot finish its block.
+static void bc_vm_batchRecv(int fd, void *data, size_t len) {
+
+	char *ptr = data;
+
+	while (len) {
+
+		ssize_t r = read(fd, ptr, len);
+
+		if (BC_ERR(r <= 0)) {
+			if (r < 0 && errno == EINTR) continue;
+			bc_vm_err(BC_ERR_FATAL_IO_ERR);
+		}
+
+		ptr += r;
+		len -= (size_t) r;
+	}
+}
+
+// Prints what a worker sends back for a block, with each error going to
+// stderr between the output from before and after it. Returns the first error
+// in the block.
+static BcStatus bc_vm_batchOutput(int fd) {
+
+	char data[BC_VM_BUF_SIZE];
+	size_t rec[2], n;
+
+	while (true) {
+
+		BcFile *f;
+
+		bc_vm_batchRecv(fd, rec, sizeof(rec));
+
+		if (rec[0] == BC_VM_BATCH_END) break;
+
+		f = rec[0] == BC_VM_BATCH_ERR ? &vm.ferr : &vm.fout;
+
+		if (f == &vm.ferr) bc_file_flush(&vm.fout);
+
+		for (; rec[1]; rec[1] -= n) {
+			n = rec[1] < BC_VM_BUF_SIZE ? rec[1] : BC_VM_BUF_SIZE;
+			bc_vm_batchRecv(fd, data, n);
+			bc_file_write(f, data, n);
+		}
+
+		if (f == &vm.ferr) bc_file_flush(&vm.ferr);
+	}
+
+	return (BcStatus) rec[1];
+}
+
+// Moves up to BC_VM_BATCH_LINES lines from the start of buf to the end of
+// block, reading more from fd as needed. Returns false if there are none.
+static bool bc_vm_batchBlock(int fd, BcVec *buf, BcVec *block, bool *eof) {
+
+	char data[BC_VM_BUF_SIZE];
+	size_t lines = 0, pos = 0;
+
+	while (lines < BC_VM_BATCH_LINES) {
+
+		char *nl = memchr(buf->v + pos, '\n', buf->len - pos);
+		ssize_t r;
+
+		if (nl != NULL) {
+			pos = (size_t) (nl - buf->v) + 1;
+			lines += 1;
+			continue;
+		}
+
+		if (*eof) {
+			pos = buf->len;
+			break;
+		}
+
+		r = read(fd, data, BC_VM_BUF_SIZE);
+
+		if (BC_ERR(r < 0)) {
+			if (errno == EINTR) continue;
+			bc_vm_err(BC_ERR_FATAL_IO_ERR);
+		}
+
+		if (BC_ERR(memchr(data, '\0', (size_t) r) != NULL))
+			bc_vm_verr(BC_ERR_FATAL_BIN_FILE, bc_program_stdin_name);
+
+		*eof = (r == 0);
+
+		BC_SIG_LOCK;
+		bc_vec_npush(buf, (size_t) r, data);
+		BC_SIG_UNLOCK;
+	}
+
+	if (!pos) return false;
+
+	BC_SIG_LOCK;
+
+	bc_vec_npush(block, pos, buf->v);
+
+	buf->len -= pos;
+	memmove(buf->v, buf->v + pos, buf->len);
+
+	BC_SIG_UNLOCK;
+
+	return true;
+}
+
+// Starts the workers, each with a pipe to send it blocks of lines and one to
+// send the output back. The first process keeps one end of each, in order, in
+// fds. Returns true in a worker once it is done.
+static bool bc_vm_batchFork(BcVmServer *srv, BcVec *fds, BcVec *buf,
+                            size_t jobs)
+{
+	size_t i;
+
+	BC_SIG_ASSERT_LOCKED;
+
+	for (i = 0; i < jobs; ++i) {
+
+		int p[2], q[2];
+		pid_t pid;
+
+		if (BC_ERR(pipe(p) < 0)) bc_vm_err(BC_ERR_FATAL_IO_ERR);
+
+		if (BC_ERR(pipe(q) < 0)) {
+			close(p[0]);
+			close(p[1]);
+			bc_vm_err(BC_ERR_FATAL_IO_ERR);
+		}
+
+		pid = fork();
+
+		if (BC_ERR(pid < 0)) bc_vm_err(BC_ERR_FATAL_IO_ERR);
+
+		if (!pid) {
+
+			size_t j;
+
+			// The first process is the only one that reads stdin or talks to
+			// the other workers.
+			close(srv->in);
+			close(p[1]);
+			close(q[0]);
+
+			for (j = 0; j < fds->len; ++j) close(*((int*) bc_vec_item(fds, j)));
+
+			bc_vec_npop(fds, fds->len);
+			bc_vec_npop(&srv->pids, srv->pids.len);
+
+			srv->in = p[0];
+			srv->batch = true;
+
+			vm.server = srv;
+
+			BC_SIG_UNLOCK;
+
+			bc_vm_batchWorker(p[0], q[1], buf, i, jobs);
+
+			BC_SIG_LOCK;
+
+			return true;
+		}
+
+		close(p[0]);
+		close(q[1]);
+
+		bc_vec_push(&srv->pids, &pid);
+		bc_vec_push(fds, p + 1);
+		bc_vec_push(fds, q);
+	}
+
+	return false;
 }
 
+// Hands the blocks of lines from stdin to the workers, or runs them itself if
+// there are none, and prints the output of each block in order.
+static void bc_vm_batchRun(BcVmServer *srv, BcVec *fds, BcVec *buf,
+                           BcVec *block, size_t jobs)
+{
+	size_t sent = 0, done = 0;
+	bool eof = false;
+	BcStatus s;
+
+	if (jobs == 1) {
+
+		while (bc_vm_batchBlock(srv->in, buf, block, &eof)) {
+
+			BC_SIG_LOCK;
+			bc_vec_pushByte(block, '\0');
+			BC_SIG_UNLOCK;
+
+			bc_vm_batchLines(block->v, sent * BC_VM_BATCH_LINES + 1);
+
+			BC_SIG_LOCK;
+			bc_vec_npop(block, block->len);
+			BC_SIG_UNLOCK;
+
+			sent += 1;
+		}
+
+		return;
+	}
+
+	// Every worker has one block at a time, and their output is read back in
+	// the order the blocks were sent.
+	while (true) {
+
+		int fd;
+
+		while (sent - done < jobs &&
+		       bc_vm_batchBlock(srv->in, buf, block, &eof))
+		{
+			fd = *((int*) bc_vec_item(fds, (sent % jobs) * 2));
+
+			BC_SIG_LOCK;
+			bc_vec_pushByte(block, '\0');
+			BC_SIG_UNLOCK;
+
+			bc_vm_serverWrite(fd, block->v, block->len);
+
+			BC_SIG_LOCK;
+			bc_vec_npop(block, block->len);
+			BC_SIG_UNLOCK;
+
+			sent += 1;
+		}
+
+		if (sent == done) break;
+
+		fd = *((int*) bc_vec_item(fds, (done % jobs) * 2 + 1));
+
+		// The status comes from the first error in the input, whichever
+		// worker had it.
+		s = bc_vm_batchOutput(fd);
+		if (s != BC_STATUS_SUCCESS && !srv->status) srv->status = s;
+
+		done += 1;
+	}
+}
+
+static void bc_vm_batch(void) {
+
+	BcVmServer srv;
+	BcVec buf, block, fds;
+	size_t i, jobs = vm.jobs ? vm.jobs : 1;
+	int null;
+
+	// The libraries and files may leave code in main, and the snapshot has to
+	// have what it did.
+	bc_program_exec(&vm.prog);
+
+	BC_SIG_LOCK;
+
+	bc_vec_init(&buf, sizeof(char), NULL);
+	bc_vec_init(&block, sizeof(char), NULL);
+	bc_vec_init(&fds, sizeof(int), NULL);
+	bc_vm_serverInit(&srv);
+
+	BC_SETJMP_LOCKED(err);
+
+	// The lines come from stdin, so read() cannot have it.
+	srv.in = dup(STDIN_FILENO);
+	null = open("/dev/null", O_RDONLY);
+
+	if (BC_ERR(srv.in < 0 || null < 0)) bc_vm_err(BC_ERR_FATAL_IO_ERR);
+
+	dup2(null, STDIN_FILENO);
+	close(null);
+
+	bc_file_flush(&vm.fout);
+
+	if (jobs > 1 && bc_vm_batchFork(&srv, &fds, &block, jobs)) goto err;
+
+	vm.server = &srv;
+
+	BC_SIG_UNLOCK;
+
+	bc_vm_batchRun(&srv, &fds, &buf, &block, jobs);
+
+err:
+	BC_SIG_MAYLOCK;
+
+	// Anything a worker prints after its last block goes to stderr again.
+	if (srv.batch) {
+		vm.ferr.fd = STDERR_FILENO;
+		srv.batch = false;
+	}
+
+	if (srv.in >= 0) close(srv.in);
+
+	for (i = 0; i < fds.len; ++i) close(*((int*) bc_vec_item(&fds, i)));
+
+	// The workers see end of file, finish, and exit with their own status,
+	// unless they are being stopped.
+	if (vm.status == BC_STATUS_SUCCESS) {
+
+		for (i = 0; i < srv.pids.len; ++i) {
+
+			int s;
+
+			if (waitpid(*((pid_t*) bc_vec_item(&srv.pids, i)), &s, 0) >= 0 &&
+			    WIFEXITED(s) && WEXITSTATUS(s) && !srv.status)
+			{
+				srv.status = (BcStatus) WEXITSTATUS(s);
+			}
+		}
+
+		bc_vec_npop(&srv.pids, srv.pids.len);
+
+		vm.status = (sig_atomic_t) srv.status;
+	}
+
+	bc_vm_serverFree(&srv);
+	bc_vec_free(&fds);
+	bc_vec_free(&block);
+	bc_vec_free(&buf);
+
+	BC_LONGJMP_CONT;
+}
+#endif // BC_VM_SERVER
+
 static void bc_vm_exec(void) {
 
 	size_t i;
@@ -749,14 +1872,22 @@ static void bc_vm_exec(void) {
 #if BC_ENABLED
 	if (BC_IS_BC && (vm.flags & BC_FLAG_L)) {
 
-		bc_vm_load(bc_lib_name, bc_lib);
+		bc_vm_loadLib(bc_lib_name, bc_lib, bc_lib_code, bc_lib_code_len);
 
 #if BC_ENABLE_EXTRA_MATH
-		if (!BC_IS_POSIX) bc_vm_load(bc_lib2_name, bc_lib2);
+		if (!BC_IS_POSIX)
+			bc_vm_loadLib(bc_lib2_name, bc_lib2, bc_lib2_code, bc_lib2_code_len);
 #endif // BC_ENABLE_EXTRA_MATH
 	}
 #endif // BC_ENABLED
 
+#if BC_VM_SERVER
+	if (vm.server_path != NULL) {
+		bc_vm_server();
+		return;
+	}
+#endif // BC_VM_SERVER
+
 	if (vm.exprs.len) {
 
 		size_t len = vm.exprs.len - 1;
@@ -799,10 +1930,18 @@ static void bc_vm_exec(void) {
 		char *path = *((char**) bc_vec_item(&vm.files, i));
 		if (!strcmp(path, "")) continue;
 		has_file = true;
-		bc_vm_file(path);
+		if (BC_R) bc_vm_stream(path);
+		else bc_vm_file(path);
 	}
 
-	if (BC_IS_BC || !has_file) bc_vm_stdin();
+	if (BC_IS_BC || !has_file) {
+#if BC_VM_SERVER
+		if (vm.batch) bc_vm_batch();
+		else bc_vm_stdin();
+#else // BC_VM_SERVER
+		bc_vm_stdin();
+#endif // BC_VM_SERVER
+	}
 
 // These are all protected by ifndef NDEBUG because if these are needed, bc is
 // goingi to exit anyway, and I see no reason to include this code in a release
@@ -849,7 +1988,9 @@ void bc_vm_boot(int argc, char *argv[], const char *env_len,
 
 	vm.file = NULL;
 
-	bc_vm_gettext();
+#if BC_ENABLE_NLS
+	vm.catalog = BC_VM_INVALID_CATALOG;
+#endif // BC_ENABLE_NLS
 
 	bc_file_init(&vm.ferr, STDERR_FILENO, output_bufs + BC_VM_STDOUT_BUF_SIZE,
 	             BC_VM_STDERR_BUF_SIZE);
@@ -872,6 +2013,10 @@ void bc_vm_boot(int argc, char *argv[], const char *env_len,
 	if (BC_IS_BC) vm.flags |= BC_FLAG_S * (getenv("POSIXLY_CORRECT") != NULL);
 #endif // BC_ENABLED
 
+#if BC_VM_CACHE
+	if (BC_IS_BC) vm.cache_dir = bc_vm_cacheDir(getenv("BC_CACHE_DIR"));
+#endif // BC_VM_CACHE
+
 	bc_vm_envArgs(env_args);
 	bc_args(argc, argv);
 
@@ -883,6 +2028,42 @@ void bc_vm_boot(int argc, char *argv[], const char *env_len,
 
 	bc_vm_exec();
 }
+
+#if BC_ENABLED
+void bc_vm_compile(BcVec *lib, BcVec *lib2) {
+
+	BcBytecodeMark m;
+
+	BC_SIG_ASSERT_LOCKED;
+
+	bc_vm_init();
+	bc_vm_defaultMsgs();
+
+	bc_file_init(&vm.ferr, STDERR_FILENO, output_bufs + BC_VM_STDOUT_BUF_SIZE,
+	             BC_VM_STDERR_BUF_SIZE);
+	bc_file_init(&vm.fout, STDOUT_FILENO, output_bufs, BC_VM_STDOUT_BUF_SIZE);
+	vm.buf = output_bufs + BC_VM_STDOUT_BUF_SIZE + BC_VM_STDERR_BUF_SIZE;
+
+	bc_program_init(&vm.prog);
+	bc_parse_init(&vm.prs, &vm.prog, BC_PROG_MAIN);
+
+	BC_SIG_UNLOCK;
+
+	bc_bytecode_mark(&vm.prog, &m);
+	bc_vm_load(bc_lib_name, bc_lib);
+	bc_bytecode_save(&vm.prog, &m, NULL, lib);
+
+#if BC_ENABLE_EXTRA_MATH
+	bc_bytecode_mark(&vm.prog, &m);
+	bc_vm_load(bc_lib2_name, bc_lib2);
+	bc_bytecode_save(&vm.prog, &m, NULL, lib2);
+#else // BC_ENABLE_EXTRA_MATH
+	BC_UNUSED(lib2);
+#endif // BC_ENABLE_EXTRA_MATH
+
+	BC_SIG_LOCK;
+}
+#endif // BC_ENABLED
 #endif // !BC_ENABLE_LIBRARY
 
 void bc_vm_init(void) {
@@ -113,6 +113,9 @@ sh "$testdir/stdin.sh" "$d" "$exe" "$@"
 sh "$testdir/scripts.sh" "$d" "$extra" "$run_stack_tests" "$generate_tests" "$time_tests" "$exe" "$@"
 sh "$testdir/read.sh" "$d" "$exe" "$@"
 sh "$testdir/errors.sh" "$d" "$exe" "$@"
+sh "$testdir/server.sh" "$d" "$exe" "$@"
+sh "$testdir/batch.sh" "$d" "$exe" "$@"
+sh "$testdir/profile.sh" "$d" "$exe" "$@"
 
 num=100000000000000000000000000000000000000000000000000000000000000000000000000000
 numres="$num"
@@ -0,0 +1,137 @@
+#! /bin/sh
+#
+# SPDX-License-Identifier: BSD-2-Clause
+#
+# Copyright (c) 2018-2020 Gavin D. Howard and contributors.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+#
+
+set -e
+
+script="$0"
+testdir=$(dirname "$script")
+
+. "$testdir/../functions.sh"
+
+if [ "$#" -lt 1 ]; then
+	printf 'usage: %s dir [exe [args...]]\n' "$0"
+	printf 'valid dirs are:\n'
+	printf '\n'
+	cat "$testdir/all.txt"
+	printf '\n'
+	exit 1
+fi
+
+d="$1"
+shift
+
+if [ "$#" -gt 0 ]; then
+	exe="$1"
+	shift
+else
+	exe="$testdir/../bin/$d"
+fi
+
+if [ "$d" != "bc" ]; then
+	exit 0
+fi
+
+out="$testdir/../.log_${d}_test.txt"
+results="$testdir/../.log_${d}_batch_results.txt"
+defs="$testdir/../.log_${d}_batch.txt"
+
+unset BC_LINE_LENGTH BC_ENV_ARGS
+
+printf 'Running %s batch tests...' "$d"
+
+# These tests have one calculation per line, and together they are more than a
+# few blocks of lines.
+tests="add subtract multiply power comp boolean"
+
+rm -f "$results"
+
+for t in $tests; do
+	cat "$testdir/$d/${t}_results.txt" >> "$results"
+done
+
+for jobs in 1 3; do
+	for t in $tests; do
+		cat "$testdir/$d/$t.txt"
+	done | "$exe" "$@" -lq -B -j "$jobs" > "$out"
+	diff "$results" "$out"
+done
+
+# Every line starts from what the files left, whatever the lines before it did.
+printf 'x = 7\ndefine f(n) { return n * x; }\nscale = 4\n' > "$defs"
+printf 'f(2)\nx = 1; f(2)\nf(2)\ndefine f(n) { return n; }; f(2)\nf(2)\n1/3\n' | \
+	"$exe" "$@" -q -B -j 2 "$defs" > "$out"
+printf '14\n2\n14\n2\n14\n.3333\n' | diff - "$out"
+
+# An error only ends its line, and bc exits with its status.
+set +e
+printf '1\n1 +\n3\n' | "$exe" "$@" -q -B > "$out" 2> /dev/null
+err="$?"
+set -e
+
+if [ "$err" -ne 2 ]; then
+	err_exit "$d batch returned $err on a parse error" 1
+fi
+
+printf '1\n3\n' | diff - "$out"
+
+# Workers send their errors back, so they come out where the line was.
+for jobs in 1 3; do
+	set +e
+	printf '1\n1/0\n2\n' | "$exe" "$@" -q -B -j "$jobs" > "$out" 2>&1
+	set -e
+	if [ "$(head -n 1 "$out")" != 1 ] || [ "$(tail -n 1 "$out")" != 2 ] || \
+		[ "$(wc -l < "$out")" -le 2 ]
+	then
+		err_exit "$d batch printed an error out of order with $jobs jobs" 1
+	fi
+done
+
+# Output can have any byte in it, and it still has to end up on stdout.
+for jobs in 1 2; do
+	printf '"a\001b"\n2\n' | "$exe" "$@" -q -B -j "$jobs" > "$out" 2> "$results"
+	printf 'a\001b2\n' | cmp -s - "$out" && [ ! -s "$results" ] || \
+		err_exit "$d batch split its output with $jobs jobs" 1
+done
+
+# The status comes from the first error in the input, not the first worker. The
+# second block of lines has a parse error, and the third, which goes to the
+# same worker as the first, has a math error.
+ones=$(awk 'BEGIN { for (i = 0; i < 300; ++i) print 1 }')
+set +e
+printf '%s\n1 +\n%s\n1/0\n' "$ones" "$ones" | "$exe" "$@" -q -B -j 2 > /dev/null 2>&1
+err="$?"
+set -e
+
+if [ "$err" -ne 2 ]; then
+	err_exit "$d batch returned $err instead of the first error" 1
+fi
+
+rm -f "$out" "$results" "$defs"
+
+printf 'pass\n'
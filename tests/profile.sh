@@ -0,0 +1,113 @@
+#! /bin/sh
+#
+# SPDX-License-Identifier: BSD-2-Clause
+#
+# Copyright (c) 2018-2020 Gavin D. Howard and contributors.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+#
+
+
+set -e
+
+script="$0"
+testdir=$(dirname "$script")
+
+. "$testdir/../functions.sh"
+
+if [ "$#" -lt 1 ]; then
+	printf 'usage: %s dir [exe [args...]]\n' "$0"
+	printf 'valid dirs are:\n'
+	printf '\n'
+	cat "$testdir/all.txt"
+	printf '\n'
+	exit 1
+fi
+
+d="$1"
+shift
+
+if [ "$#" -gt 0 ]; then
+	exe="$1"
+	shift
+else
+	exe="$testdir/../bin/$d"
+fi
+
+out="$testdir/../.log_${d}_test.txt"
+prof="$testdir/../.log_${d}_profile.txt"
+
+unset BC_LINE_LENGTH BC_ENV_ARGS DC_ENV_ARGS
+
+printf 'Running %s profile tests...' "$d"
+
+if [ "$d" = "bc" ]; then
+	prog='define f(x) { return x * 2; }; f(1); f(2); f(3)'
+	name='"f"'
+	opts="-q"
+else
+	prog='[2*]sf 1lfxp 2lfxp 3lfxp'
+	name='"2\*"'
+	opts=""
+fi
+
+# The program runs as usual, and the report goes to stderr.
+printf '%s\n' "$prog" | "$exe" "$@" $opts -p csv > "$out" 2> "$prof"
+printf '2\n4\n6\n' | diff - "$out"
+
+head -n 1 "$prof" | grep -q '^kind,name,count,calls,ticks,digits,max_digits$'
+grep -q '^instruction,MULTIPLY,3,,[0-9]*,[0-9]*,[0-9]*$' "$prof"
+grep -q "^function,$name,[0-9]*,3,[0-9]*,,$" "$prof"
+
+printf '%s\n' "$prog" | "$exe" "$@" $opts -p json > "$out" 2> "$prof"
+printf '2\n4\n6\n' | diff - "$out"
+
+head -n 1 "$prof" | grep -q '^{$'
+tail -n 1 "$prof" | grep -q '^}$'
+grep -q '"name": "MULTIPLY", "count": 3,' "$prof"
+
+printf '%s\n' "$prog" | "$exe" "$@" $opts --profile=text > "$out" 2> "$prof"
+printf '2\n4\n6\n' | diff - "$out"
+
+grep -q '\.[0-9]  *3  .*  MULTIPLY$' "$prof"
+
+# bc also says how often pure functions used a remembered result.
+if [ "$d" = "bc" ]; then
+	printf 'define pure f(n) { return n; }; f(1); f(1); f(2)\n' | \
+		"$exe" "$@" -q -p csv > "$out" 2> "$prof"
+	grep -q '^pure,hits,1,,,,$' "$prof"
+	grep -q '^pure,misses,2,,,,$' "$prof"
+fi
+
+set +e
+printf '%s\n' "$prog" | "$exe" "$@" $opts -p xml > "$out" 2> /dev/null
+err="$?"
+set -e
+
+if [ "$err" -eq 0 ]; then
+	err_exit "$d did not fail on a bad profile format" 1
+fi
+
+rm -f "$out" "$prof"
+
+printf 'pass\n'
@@ -150,6 +150,37 @@ fi
 
 diff "$res" "$out"
 
+# The first run saves the parsed script, and the second runs what it saved.
+if [ "$d" = "bc" ]; then
+
+	cache="$testdir/../.cache_${d}_test"
+
+	rm -rf "$cache"
+	mkdir -m 700 "$cache"
+
+	for i in 1 2; do
+		printf '%s\n' "$halt" | BC_CACHE_DIR="$cache" "$exe" "$@" $options "$s" > "$out"
+		diff "$res" "$out"
+	done
+
+	# A file that others can write is not run, so it is saved again.
+	find "$cache" -type f -exec chmod go+w {} +
+	printf '%s\n' "$halt" | BC_CACHE_DIR="$cache" "$exe" "$@" $options "$s" > "$out"
+	diff "$res" "$out"
+
+	[ -z "$(find "$cache" -type f -perm -g+w)" ]
+
+	# Nothing is saved in a directory that others can write.
+	rm -f "$cache"/*
+	chmod go+w "$cache"
+	printf '%s\n' "$halt" | BC_CACHE_DIR="$cache" "$exe" "$@" $options "$s" > "$out"
+	diff "$res" "$out"
+
+	[ -z "$(ls "$cache")" ]
+
+	rm -rf "$cache"
+fi
+
 rm -f "$out"
 
 printf 'pass\n'
@@ -0,0 +1,119 @@
+#! /bin/sh
+#
+# SPDX-License-Identifier: BSD-2-Clause
+#
+# Copyright (c) 2018-2020 Gavin D. Howard and contributors.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+#
+
+set -e
+
+script="$0"
+testdir=$(dirname "$script")
+
+. "$testdir/../functions.sh"
+
+if [ "$#" -lt 1 ]; then
+	printf 'usage: %s dir [exe [args...]]\n' "$0"
+	printf 'valid dirs are:\n'
+	printf '\n'
+	cat "$testdir/all.txt"
+	printf '\n'
+	exit 1
+fi
+
+d="$1"
+shift
+
+if [ "$#" -gt 0 ]; then
+	exe="$1"
+	shift
+else
+	exe="$testdir/../bin/$d"
+fi
+
+if [ "$d" != "bc" ]; then
+	exit 0
+fi
+
+if ! command -v python3 > /dev/null 2>&1; then
+	printf 'Skipping %s server tests; python3 is needed for the client\n' "$d"
+	exit 0
+fi
+
+client="$testdir/server.py"
+out="$testdir/../.log_${d}_test.txt"
+
+# The path of a UNIX socket cannot be very long, so it is not in the build dir.
+sock="${TMPDIR:-/tmp}/.${d}_server_test.$$"
+
+unset BC_LINE_LENGTH BC_ENV_ARGS
+
+rm -f "$sock"
+
+printf 'Running %s server tests...' "$d"
+
+"$exe" "$@" -lq -j 2 -S "$sock" < /dev/null &
+pid="$!"
+
+trap 'kill "$pid" 2> /dev/null; rm -f "$sock"' EXIT
+
+for t in decimal add subtract multiply divide modulus power sqrt vars boolean \
+         comp functions globals strings letters exponent log arctangent sine \
+         cosine arrays misc1 misc2 misc3 void
+do
+	python3 "$client" "$sock" < "$testdir/$d/$t.txt" > "$out"
+	diff "$testdir/$d/${t}_results.txt" "$out"
+done
+
+# Nothing that one request does may be seen by the next, including a library
+# function that it defines again.
+printf 'a = 5\nb[2] = 3\ndefine s(x) { return 7; }\nscale = 3\nibase = 16\n' | \
+	python3 "$client" "$sock" > "$out"
+printf 'a\nb[2]\nscale\nibase\ns(1)\n' | python3 "$client" "$sock" > "$out"
+printf '0\n0\n20\n10\n.84147098480789650665\n' | diff - "$out"
+
+# Errors go back to the client, and they, and halt, only end the request.
+printf 'x = 1 / 0\n' | python3 "$client" "$sock" > "$out"
+
+if [ ! -s "$out" ]; then
+	err_exit "$d server did not send back an error" 1
+fi
+
+printf 'halt\n' | python3 "$client" "$sock" > "$out"
+printf '1 + 1\n' | python3 "$client" "$sock" > "$out"
+printf '2\n' | diff - "$out"
+
+kill "$pid"
+wait "$pid"
+
+trap - EXIT
+
+if [ -e "$sock" ]; then
+	err_exit "$d server did not remove $sock" 1
+fi
+
+rm -f "$out"
+
+printf 'pass\n'
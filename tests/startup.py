@@ -0,0 +1,121 @@
+#! /usr/bin/python3 -B
+#
+# SPDX-License-Identifier: BSD-2-Clause
+#
+# Copyright (c) 2018-2020 Gavin D. Howard and contributors.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of source code must retain the above copyright notice, this
+#   list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+#
+
+# Measures how long bc or dc takes from exec to the first byte of output for a
+# one-shot `echo expr | bc` style invocation, which is dominated by startup.
+
+import os
+import sys
+import subprocess
+import time
+
+def usage():
+	print("usage: {} [bc|dc] [num_iterations [exe [args...]]]".format(script))
+	print("\n    num_iterations is the number of times to run exe; default is 1000")
+	sys.exit(1)
+
+def ms(t):
+	return "{:.3f} ms".format(t * 1000)
+
+def report(name, times):
+	times = sorted(times)
+	n = len(times)
+	print("{:<6} min {}, median {}, p90 {}".format(name, ms(times[0]),
+	      ms(times[n // 2]), ms(times[(n * 9) // 10])))
+
+script = sys.argv[0]
+testdir = os.path.dirname(script)
+
+if __name__ != "__main__":
+	usage()
+
+if len(sys.argv) >= 2:
+	d = sys.argv[1]
+else:
+	d = "bc"
+
+if d == "bc":
+	indata = b"1+1\n"
+elif d == "dc":
+	indata = b"1 1+p\n"
+else:
+	usage()
+
+if len(sys.argv) >= 3:
+	num_iterations = int(sys.argv[2])
+else:
+	num_iterations = 1000
+
+if num_iterations < 1:
+	usage()
+
+if len(sys.argv) >= 4:
+	exe = sys.argv[3:]
+else:
+	exe = [ "{}/../bin/{}".format(testdir, d) ]
+
+# The cache would turn later runs into something other than a cold start.
+env = dict(os.environ)
+env.pop("BC_CACHE_DIR", None)
+env.pop("BC_ENV_ARGS", None)
+env.pop("DC_ENV_ARGS", None)
+
+first = []
+total = []
+
+print("Timing {} startup over {} runs...".format(d, num_iterations))
+
+# The first few runs only warm up the page cache and are not counted.
+for i in range(0, num_iterations + 10):
+
+	start = time.perf_counter()
+
+	p = subprocess.Popen(exe, stdin=subprocess.PIPE, stdout=subprocess.PIPE,
+	                     stderr=subprocess.DEVNULL, env=env)
+	p.stdin.write(indata)
+	p.stdin.close()
+
+	c = os.read(p.stdout.fileno(), 1)
+	out = time.perf_counter()
+
+	p.stdout.read()
+	p.stdout.close()
+	ret = p.wait()
+	end = time.perf_counter()
+
+	if ret != 0 or c != b"2":
+		print("{} returned an error or bad output; exiting...".format(d))
+		sys.exit(ret if ret != 0 else 1)
+
+	if i >= 10:
+		first.append(out - start)
+		total.append(end - start)
+
+report("output", first)
+report("exit", total)
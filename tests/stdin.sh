@@ -74,6 +74,16 @@ if [ "$d" = "bc" ]; then
 
 	cat "$testdir/$d/stdin2.txt" | "$exe" "$@" "$options" > "$out" 2> /dev/null
 	diff "$testdir/$d/stdin2_results.txt" "$out"
+
+	# Streamed files are read the same way as stdin.
+	"$exe" "$@" -lqR "$testdir/$d/stdin1.txt" < /dev/null > "$out" 2> /dev/null
+	diff "$testdir/$d/stdin1_results.txt" "$out"
+
+	"$exe" "$@" -lqR "$testdir/$d/stdin2.txt" < /dev/null > "$out" 2> /dev/null
+	diff "$testdir/$d/stdin2_results.txt" "$out"
+else
+	"$exe" "$@" -xR "$testdir/$d/stdin.txt" > "$out" 2> /dev/null
+	diff "$testdir/$d/stdin_results.txt" "$out"
 fi
 
 rm -f "$out1"